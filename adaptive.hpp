@@ -0,0 +1,530 @@
+#ifndef ADAPTIVE_HPP
+#define ADAPTIVE_HPP
+
+#include "cunits.hpp"
+#include "stats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+// The adaptive store of sunits for integral endpoints.  The store
+// keeps the intervals either in a vector (as vector_store does), or
+// in a bitmap of the units, and migrates between the two.  The vector
+// is better for few intervals, and the bitmap is better for many
+// intervals in a small range of units, i.e., for a fragmented set.
+//
+// After every change we compare the bytes the vector takes (2
+// endpoints per interval) with the bytes the bitmap takes (a bit per
+// unit in the range of the set, in 64-bit words).  We migrate to the
+// bitmap when the vector takes more than twice as much as the bitmap,
+// and back to the vector when the vector takes less than half of the
+// bitmap.  That's the hysteresis that prevents migrating back and
+// forth.  Before the bitmap grows for an insert, we check that it
+// would still be worth it, and migrate to the vector first if not, so
+// an interval far from the others never allocates the bitmap of the
+// units in between.  When the lowest or the highest intervals are
+// erased, the bitmap shrinks to the words of the remaining ones.
+//
+// The store yields the intervals as cunits<T> by value in the same
+// order, so the semantics of sunits stay the same.  In the bitmap,
+// the intervals are the runs of ones, which are separated by zeros,
+// because sunits never keeps touching intervals.
+
+template <std::integral T>
+class adaptive_store
+{
+  using word_type = std::uint64_t;
+  using unsigned_type = std::make_unsigned_t<T>;
+  static constexpr std::size_t W = 64;
+  static constexpr std::size_t npos = -1;
+
+  // The intervals when in the vector.
+  std::vector<cunits<T>, units_allocator<cunits<T>>> m_vector;
+
+  // The bitmap: bit p stands for unit m_lo + p.
+  std::vector<word_type, units_allocator<word_type>> m_bitmap;
+  T m_lo = T();
+
+  // Are the intervals in the bitmap?
+  bool m_in_bitmap = false;
+
+  // The number of intervals.
+  std::size_t m_n = 0;
+
+public:
+  using value_type = cunits<T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  // The position k is the index of the interval in the vector, or
+  // the bit of the interval min in the bitmap.
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using value_type = cunits<T>;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+    using pointer = cunits_pointer<T>;
+
+  private:
+    const adaptive_store *m_s = nullptr;
+    std::size_t m_k = 0;
+
+  public:
+    const_iterator() = default;
+
+    const_iterator(const adaptive_store *s, std::size_t k): m_s(s), m_k(k)
+    {
+    }
+
+    value_type
+    operator * () const
+    {
+      return m_s->at(m_k);
+    }
+
+    pointer
+    operator -> () const
+    {
+      return {**this};
+    }
+
+    const_iterator &
+    operator ++ ()
+    {
+      m_k = m_s->next(m_k);
+      return *this;
+    }
+
+    const_iterator
+    operator ++ (int)
+    {
+      auto t = *this;
+      ++*this;
+      return t;
+    }
+
+    const_iterator &
+    operator -- ()
+    {
+      m_k = m_s->prev(m_k);
+      return *this;
+    }
+
+    const_iterator
+    operator -- (int)
+    {
+      auto t = *this;
+      --*this;
+      return t;
+    }
+
+    bool
+    operator == (const const_iterator &i) const
+    {
+      return m_k == i.m_k;
+    }
+
+    std::size_t
+    position() const
+    {
+      return m_k;
+    }
+  };
+
+  using iterator = const_iterator;
+
+  const_iterator
+  begin() const
+  {
+    return {this, m_in_bitmap ? next_one(0) : 0};
+  }
+
+  const_iterator
+  end() const
+  {
+    return {this, m_in_bitmap ? bits() : m_vector.size()};
+  }
+
+  size_type
+  size() const
+  {
+    return m_n;
+  }
+
+  bool
+  empty() const
+  {
+    return !m_n;
+  }
+
+  // Are the intervals in the bitmap?
+  bool
+  in_bitmap() const
+  {
+    return m_in_bitmap;
+  }
+
+  // Returns iterator i to the first interval such that iv > *i.
+  const_iterator
+  upper_bound(const value_type &iv) const
+  {
+    if (!m_in_bitmap)
+      return {this, std::size_t(std::upper_bound(m_vector.begin(),
+                                                 m_vector.end(), iv,
+                                                 std::greater<value_type>())
+                                - m_vector.begin())};
+
+    // Every interval starts after iv.min.
+    if (iv.min() < m_lo)
+      return begin();
+
+    std::size_t b = bit(iv.min());
+    if (b >= bits())
+      return end();
+
+    // The interval that starts at iv.min is less than iv if its max
+    // is less than the max of iv.
+    if (test(b) && (!b || !test(b - 1)))
+      return {this, bit(iv.max()) > next_zero(b) ? b : next(b)};
+
+    // The first interval that starts after iv.min.
+    return {this, next_one(test(b) ? next_zero(b) : b)};
+  }
+
+  // Insert interval cu before position i.
+  const_iterator
+  insert(const_iterator i, const value_type &cu)
+  {
+    // The bitmap would grow too much: the vector first.
+    if (m_in_bitmap && !bitmap_suits(m_n + 1, cover(cu)))
+      {
+        to_vector();
+        i = locate(cu.min());
+      }
+
+    if (m_in_bitmap)
+      {
+        fit(cu);
+        set(bit(cu.min()), bit(cu.max()), true);
+      }
+    else
+      m_vector.insert(m_vector.begin() + i.position(), cu);
+
+    ++m_n;
+    adapt();
+    return locate(cu.min());
+  }
+
+  const_iterator
+  erase(const_iterator i)
+  {
+    return erase(i, std::next(i));
+  }
+
+  const_iterator
+  erase(const_iterator i, const_iterator j)
+  {
+    // Where j points to, so that we can find it after adapting.
+    std::optional<T> next;
+    if (j != end())
+      next = (*j).min();
+
+    for (auto k = i; k != j; ++k)
+      --m_n;
+
+    if (!m_n)
+      {
+        clear();
+        return end();
+      }
+
+    if (m_in_bitmap)
+      {
+        set(i.position(), j.position(), false);
+        trim();
+      }
+    else
+      m_vector.erase(m_vector.begin() + i.position(),
+                     m_vector.begin() + j.position());
+
+    adapt();
+    return next ? locate(*next) : end();
+  }
+
+  void
+  clear()
+  {
+    m_vector.clear();
+    m_bitmap.clear();
+    m_in_bitmap = false;
+    m_n = 0;
+  }
+
+  bool
+  operator == (const adaptive_store &s) const
+  {
+    return std::equal(begin(), end(), s.begin(), s.end());
+  }
+
+private:
+  std::size_t
+  bits() const
+  {
+    return m_bitmap.size() * W;
+  }
+
+  bool
+  test(std::size_t p) const
+  {
+    return m_bitmap[p / W] >> (p % W) & 1;
+  }
+
+  // Set (or clear) the bits [a, b).
+  void
+  set(std::size_t a, std::size_t b, bool v)
+  {
+    for (; a < b;)
+      {
+        std::size_t n = std::min(b - a, W - a % W);
+        word_type m = (n == W ? ~word_type() : (word_type(1) << n) - 1)
+          << (a % W);
+        if (v)
+          m_bitmap[a / W] |= m;
+        else
+          m_bitmap[a / W] &= ~m;
+        a += n;
+      }
+  }
+
+  // The first bit at or after p which is one (or zero if x is all
+  // ones), or bits() if there is none.
+  std::size_t
+  next_bit(std::size_t p, word_type x) const
+  {
+    for (std::size_t w = p / W; w < m_bitmap.size(); ++w)
+      {
+        word_type b = m_bitmap[w] ^ x;
+        if (w == p / W)
+          b &= ~word_type() << (p % W);
+        if (b)
+          return w * W + std::countr_zero(b);
+      }
+
+    return bits();
+  }
+
+  // The last bit before p which is one (or zero if x is all ones), or
+  // npos if there is none.
+  std::size_t
+  prev_bit(std::size_t p, word_type x) const
+  {
+    if (!p)
+      return npos;
+
+    for (std::size_t w = (p - 1) / W + 1; w-- > 0;)
+      {
+        word_type b = m_bitmap[w] ^ x;
+        if (w == (p - 1) / W)
+          if (auto r = (p - 1) % W; r != W - 1)
+            b &= (word_type(1) << (r + 1)) - 1;
+        if (b)
+          return w * W + W - 1 - std::countl_zero(b);
+      }
+
+    return npos;
+  }
+
+  std::size_t
+  next_one(std::size_t p) const
+  {
+    return next_bit(p, 0);
+  }
+
+  std::size_t
+  next_zero(std::size_t p) const
+  {
+    return next_bit(p, ~word_type());
+  }
+
+  value_type
+  at(std::size_t k) const
+  {
+    if (!m_in_bitmap)
+      return m_vector[k];
+
+    return value_type(unit(k), unit(next_zero(k)));
+  }
+
+  // The position of the interval that follows the one at k.
+  std::size_t
+  next(std::size_t k) const
+  {
+    return m_in_bitmap ? next_one(next_zero(k)) : k + 1;
+  }
+
+  // The position of the interval that precedes the one at k.
+  std::size_t
+  prev(std::size_t k) const
+  {
+    if (!m_in_bitmap)
+      return k - 1;
+
+    auto z = prev_bit(prev_bit(k, 0), ~word_type());
+    return z == npos ? 0 : z + 1;
+  }
+
+  // The iterator to the interval that starts at min.
+  const_iterator
+  locate(T min) const
+  {
+    if (m_in_bitmap)
+      return {this, bit(min)};
+
+    return {this, std::size_t(std::partition_point(m_vector.begin(),
+                                                   m_vector.end(),
+                                                   [min](const auto &cu)
+                                                   {return cu.min() < min;})
+                              - m_vector.begin())};
+  }
+
+  // The start of the word with unit v.
+  static T
+  floor(T v)
+  {
+    T r = v % T(W);
+    if constexpr (std::is_signed_v<T>)
+      if (r < 0)
+        r += W;
+    return v - r;
+  }
+
+  // The number of units from a to b, where a <= b.  We count in the
+  // unsigned type, where the difference cannot overflow.
+  static unsigned_type
+  distance(T a, T b)
+  {
+    return unsigned_type(b) - unsigned_type(a);
+  }
+
+  // The bit of unit v.
+  std::size_t
+  bit(T v) const
+  {
+    return distance(m_lo, v);
+  }
+
+  // The unit of bit p.
+  T
+  unit(std::size_t p) const
+  {
+    return T(unsigned_type(m_lo) + unsigned_type(p));
+  }
+
+  // The number of words for the units [lo, hi).  We divide first, so
+  // that the rounding up cannot overflow.
+  static std::size_t
+  words(T lo, T hi)
+  {
+    auto d = distance(floor(lo), hi);
+    return std::size_t(d / W) + (d % W != 0);
+  }
+
+  // The number of words the bitmap would have to cover cu too.
+  std::size_t
+  cover(const value_type &cu) const
+  {
+    T lo = std::min(cu.min(), m_lo);
+    return std::max(words(lo, cu.max()),
+                    distance(floor(lo), m_lo) / W + m_bitmap.size());
+  }
+
+  // Is the bitmap of w words worth it for n intervals?  Not if
+  // the vector would take less than half of the bitmap.
+  static bool
+  bitmap_suits(std::size_t n, std::size_t w)
+  {
+    return 2 * n * sizeof(value_type) >= w * sizeof(word_type);
+  }
+
+  // Make the bitmap cover cu.
+  void
+  fit(const value_type &cu)
+  {
+    if (cu.min() < m_lo)
+      {
+        T lo = floor(cu.min());
+        m_bitmap.insert(m_bitmap.begin(), distance(lo, m_lo) / W, 0);
+        m_lo = lo;
+      }
+
+    if (std::size_t n = words(m_lo, cu.max()); n > m_bitmap.size())
+      m_bitmap.resize(n);
+  }
+
+  // Drop the words of zeros at both ends of the bitmap, which isn't
+  // all zeros.
+  void
+  trim()
+  {
+    auto l = std::find_if(m_bitmap.rbegin(), m_bitmap.rend(),
+                          [](word_type w) {return w;});
+    m_bitmap.erase(l.base(), m_bitmap.end());
+
+    auto f = std::find_if(m_bitmap.begin(), m_bitmap.end(),
+                          [](word_type w) {return w;});
+    m_lo = unit((f - m_bitmap.begin()) * W);
+    m_bitmap.erase(m_bitmap.begin(), f);
+  }
+
+  // Migrate if needed.
+  void
+  adapt()
+  {
+    std::size_t v = m_n * sizeof(value_type);
+
+    if (m_in_bitmap)
+      {
+        if (!bitmap_suits(m_n, m_bitmap.size()))
+          to_vector();
+      }
+    else if (m_n)
+      if (v > 2 * words(m_vector.front().min(), m_vector.back().max())
+          * sizeof(word_type))
+        to_bitmap();
+  }
+
+  void
+  to_bitmap()
+  {
+    m_lo = floor(m_vector.front().min());
+    m_bitmap.assign(words(m_lo, m_vector.back().max()), 0);
+
+    for (const auto &cu: m_vector)
+      set(bit(cu.min()), bit(cu.max()), true);
+
+    m_in_bitmap = true;
+    decltype(m_vector)().swap(m_vector);
+  }
+
+  void
+  to_vector()
+  {
+    m_vector.reserve(m_n);
+    for (auto i = begin(); i != end(); ++i)
+      m_vector.push_back(*i);
+
+    m_in_bitmap = false;
+    decltype(m_bitmap)().swap(m_bitmap);
+  }
+};
+
+#endif // ADAPTIVE_HPP
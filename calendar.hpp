@@ -0,0 +1,161 @@
+#ifndef CALENDAR_HPP
+#define CALENDAR_HPP
+
+#include "cunits.hpp"
+#include "sunits.hpp"
+
+#include <cassert>
+#include <concepts>
+#include <iterator>
+#include <map>
+#include <utility>
+
+// The calendar of the units for the advance reservations: the units
+// that are free at a given time, e.g., the slots of a link free
+// throughout a time window, over the time horizon.
+//
+// We keep a timeline: the map from the time t to the sunits that are
+// free from t until the next time in the map, or until the end of the
+// horizon.  A booking splits at most two segments of the timeline,
+// and the neighbouring segments with equal sunits are merged, so the
+// number of segments is at most twice the number of bookings plus
+// one, regardless of the length of the horizon.  A query then takes
+// an intersection per segment in the window, not per time step.
+
+template <std::totally_ordered Time, typename T,
+          typename C = vector_store<T>>
+class calendar
+{
+public:
+  using sunits_type = sunits<T, C>;
+  using window_type = cunits<Time>;
+
+private:
+  window_type m_horizon;
+  std::map<Time, sunits_type> m_timeline;
+
+public:
+  // The units are free throughout the horizon.
+  calendar(const window_type &horizon, sunits_type units):
+    m_horizon(horizon)
+  {
+    m_timeline.emplace(horizon.min(), std::move(units));
+  }
+
+  const window_type &
+  horizon() const
+  {
+    return m_horizon;
+  }
+
+  // The timeline: the segment starts at the key and ends at the next
+  // key or at the end of the horizon.
+  const std::map<Time, sunits_type> &
+  timeline() const
+  {
+    return m_timeline;
+  }
+
+  // The units free throughout the window, which must be in the
+  // horizon.
+  sunits_type
+  free(const window_type &w) const
+  {
+    assert(includes(m_horizon, w));
+
+    auto i = segment(w.min());
+    sunits_type ret = i->second;
+
+    for (++i; i != m_timeline.end() && i->first < w.max() && !ret.empty();
+         ++i)
+      ret.intersect_with(i->second);
+
+    return ret;
+  }
+
+  // Are units cu free throughout the window?
+  bool
+  fits(const window_type &w, const cunits<T> &cu) const
+  {
+    assert(includes(m_horizon, w));
+
+    for (auto i = segment(w.min());
+         i != m_timeline.end() && i->first < w.max(); ++i)
+      if (!includes(i->second, cu))
+        return false;
+
+    return true;
+  }
+
+  // Book units cu throughout the window, if they are free.
+  bool
+  book(const window_type &w, const cunits<T> &cu)
+  {
+    if (!fits(w, cu))
+      return false;
+
+    auto [first, last] = split(w);
+    for (auto i = first; i != last; ++i)
+      i->second.remove(cu);
+    coalesce(first, last);
+
+    return true;
+  }
+
+  // Release units cu booked throughout the window.
+  void
+  release(const window_type &w, const cunits<T> &cu)
+  {
+    assert(includes(m_horizon, w));
+
+    auto [first, last] = split(w);
+    for (auto i = first; i != last; ++i)
+      i->second.insert(cu);
+    coalesce(first, last);
+  }
+
+private:
+  // The segment at time t.
+  auto
+  segment(const Time &t) const
+  {
+    return std::prev(m_timeline.upper_bound(t));
+  }
+
+  // Split the segments at the ends of the window, and return the
+  // segments of the window.
+  auto
+  split(const window_type &w)
+  {
+    auto at = [this](const Time &t)
+    {
+      if (t == m_horizon.max())
+        return m_timeline.end();
+
+      auto i = std::prev(m_timeline.upper_bound(t));
+      return i->first == t ? i : m_timeline.emplace_hint(std::next(i), t,
+                                                         i->second);
+    };
+
+    auto last = at(w.max());
+    return std::pair(at(w.min()), last);
+  }
+
+  // Merge the equal neighbours among the segments of [first, last),
+  // and the segments before first and at last.
+  void
+  coalesce(typename std::map<Time, sunits_type>::iterator first,
+           typename std::map<Time, sunits_type>::iterator last)
+  {
+    auto i = first == m_timeline.begin() ? first : std::prev(first);
+    auto e = last == m_timeline.end() ? last : std::next(last);
+
+    while (std::next(i) != e)
+      if (auto j = std::next(i); i->second == j->second)
+        m_timeline.erase(j);
+      else
+        i = j;
+  }
+};
+
+#endif // CALENDAR_HPP
@@ -0,0 +1,424 @@
+#ifndef COMPACT_HPP
+#define COMPACT_HPP
+
+#include "cunits.hpp"
+#include "stats.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+// The compact store of sunits for integral endpoints.  The endpoints
+// are kept as offsets from the base (the lowest endpoint of the set)
+// in 1, 2, 4 or 8 bytes, i.e., the width.  The width is the smallest
+// that can hold the largest offset: it grows when the range of the
+// set grows, and narrows when the lowest or the highest intervals are
+// erased, and then we recode all offsets.  An empty set forgets its
+// base and width.
+//
+// The base and the width are kept in the buffer of the offsets, so
+// the store is a vector only, as the vector store is: sizeof(sunits)
+// is the same with both stores, and a new empty set allocates nothing.
+//
+// With sunits<unsigned> an interval takes 8 bytes.  With
+// sunits<unsigned, compact_store<unsigned>> an interval of a set that
+// spans less than 256 units takes 2 bytes, and less than 65536 units
+// takes 4 bytes, plus 5 bytes of the base and the width per set.  A
+// set that spans more takes 4 bytes per endpoint, as the vector store
+// does, and so it saves nothing.
+//
+// The store yields the intervals as cunits<T> by value, so the
+// interface of cunits<T> stays the same, but the intervals cannot be
+// modified through the iterators.
+
+template <std::integral T>
+class compact_store
+{
+  // The type of the offsets.
+  using offset_type = std::make_unsigned_t<T>;
+
+  // The header of the data: the width in a byte, and the base.
+  static constexpr std::size_t header = 1 + sizeof(T);
+
+  // The header, and then the offsets: the interval k has its
+  // endpoints at positions 2k and 2k + 1.  The data of an empty set is
+  // empty, without the header.
+  std::vector<unsigned char, units_allocator<unsigned char>> m_data;
+
+public:
+  using value_type = cunits<T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
+    using value_type = cunits<T>;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+    using pointer = cunits_pointer<T>;
+
+  private:
+    const compact_store *m_s = nullptr;
+    difference_type m_k = 0;
+
+  public:
+    const_iterator() = default;
+
+    const_iterator(const compact_store *s, difference_type k):
+      m_s(s), m_k(k)
+    {
+    }
+
+    value_type
+    operator * () const
+    {
+      return m_s->at(m_k);
+    }
+
+    pointer
+    operator -> () const
+    {
+      return {**this};
+    }
+
+    value_type
+    operator [] (difference_type n) const
+    {
+      return m_s->at(m_k + n);
+    }
+
+    const_iterator &
+    operator ++ ()
+    {
+      ++m_k;
+      return *this;
+    }
+
+    const_iterator
+    operator ++ (int)
+    {
+      auto t = *this;
+      ++m_k;
+      return t;
+    }
+
+    const_iterator &
+    operator -- ()
+    {
+      --m_k;
+      return *this;
+    }
+
+    const_iterator
+    operator -- (int)
+    {
+      auto t = *this;
+      --m_k;
+      return t;
+    }
+
+    const_iterator &
+    operator += (difference_type n)
+    {
+      m_k += n;
+      return *this;
+    }
+
+    const_iterator &
+    operator -= (difference_type n)
+    {
+      m_k -= n;
+      return *this;
+    }
+
+    friend const_iterator
+    operator + (const_iterator i, difference_type n)
+    {
+      return i += n;
+    }
+
+    friend const_iterator
+    operator + (difference_type n, const_iterator i)
+    {
+      return i += n;
+    }
+
+    friend const_iterator
+    operator - (const_iterator i, difference_type n)
+    {
+      return i -= n;
+    }
+
+    friend difference_type
+    operator - (const const_iterator &i, const const_iterator &j)
+    {
+      return i.m_k - j.m_k;
+    }
+
+    bool
+    operator == (const const_iterator &i) const
+    {
+      return m_k == i.m_k;
+    }
+
+    auto
+    operator <=> (const const_iterator &i) const
+    {
+      return m_k <=> i.m_k;
+    }
+
+    difference_type
+    index() const
+    {
+      return m_k;
+    }
+  };
+
+  using iterator = const_iterator;
+
+  const_iterator
+  begin() const
+  {
+    return {this, 0};
+  }
+
+  const_iterator
+  end() const
+  {
+    return {this, difference_type(size())};
+  }
+
+  size_type
+  size() const
+  {
+    return empty() ? 0 : (m_data.size() - header) / (2 * width());
+  }
+
+  bool
+  empty() const
+  {
+    return m_data.empty();
+  }
+
+  // The number of bytes an endpoint takes.
+  unsigned
+  width() const
+  {
+    return empty() ? 1 : m_data[0];
+  }
+
+  value_type
+  at(size_type k) const
+  {
+    return value_type(value(2 * k), value(2 * k + 1));
+  }
+
+  // Insert interval cu before position i.
+  const_iterator
+  insert(const_iterator i, const value_type &cu)
+  {
+    auto k = i.index();
+    fit(cu);
+    m_data.insert(m_data.begin() + position(2 * k), 2 * width(), 0);
+    set(2 * k, cu.min());
+    set(2 * k + 1, cu.max());
+    return {this, k};
+  }
+
+  const_iterator
+  erase(const_iterator i)
+  {
+    return erase(i, std::next(i));
+  }
+
+  const_iterator
+  erase(const_iterator i, const_iterator j)
+  {
+    if (i == j)
+      return i;
+
+    if (i == begin() && j == end())
+      {
+        clear();
+        return end();
+      }
+
+    // Are the lowest or the highest intervals erased?
+    bool edge = i == begin() || j == end();
+
+    auto b = m_data.begin();
+    m_data.erase(b + position(2 * i.index()), b + position(2 * j.index()));
+
+    if (edge)
+      narrow();
+
+    return {this, i.index()};
+  }
+
+  void
+  clear()
+  {
+    m_data.clear();
+  }
+
+  bool
+  operator == (const compact_store &s) const
+  {
+    return std::equal(begin(), end(), s.begin(), s.end());
+  }
+
+private:
+  // The width needed for offset o.
+  static unsigned
+  width(offset_type o)
+  {
+    unsigned w = 1;
+    while (w < sizeof(T) && (o >> (8 * w - 1) >> 1))
+      w *= 2;
+    return w;
+  }
+
+  // The position of endpoint e in the data.
+  std::size_t
+  position(std::size_t e) const
+  {
+    return header + e * width();
+  }
+
+  T
+  base() const
+  {
+    T b;
+    std::memcpy(&b, m_data.data() + 1, sizeof(b));
+    return b;
+  }
+
+  offset_type
+  offset(std::size_t e) const
+  {
+    auto *p = m_data.data() + position(e);
+
+    switch (width())
+      {
+      case 1:
+        return *p;
+      case 2:
+        {
+          std::uint16_t o;
+          std::memcpy(&o, p, sizeof(o));
+          return o;
+        }
+      case 4:
+        {
+          std::uint32_t o;
+          std::memcpy(&o, p, sizeof(o));
+          return o;
+        }
+      default:
+        {
+          std::uint64_t o;
+          std::memcpy(&o, p, sizeof(o));
+          return o;
+        }
+      }
+  }
+
+  T
+  value(std::size_t e) const
+  {
+    return T(offset_type(base()) + offset(e));
+  }
+
+  void
+  set(std::size_t e, T v)
+  {
+    offset_type o = offset_type(v) - offset_type(base());
+    auto *p = m_data.data() + position(e);
+
+    switch (width())
+      {
+      case 1:
+        *p = o;
+        break;
+      case 2:
+        {
+          std::uint16_t t = o;
+          std::memcpy(p, &t, sizeof(t));
+          break;
+        }
+      case 4:
+        {
+          std::uint32_t t = o;
+          std::memcpy(p, &t, sizeof(t));
+          break;
+        }
+      default:
+        {
+          std::uint64_t t = o;
+          std::memcpy(p, &t, sizeof(t));
+          break;
+        }
+      }
+  }
+
+  // Make the base and the width fit cu.
+  void
+  fit(const value_type &cu)
+  {
+    if (empty())
+      {
+        recode(cu.min(), width(offset_type(cu.max()) -
+                               offset_type(cu.min())));
+        return;
+      }
+
+    // The intervals are sorted, so the first has the lowest endpoint
+    // and the last has the highest.
+    T lo = std::min(cu.min(), value(0));
+    T hi = std::max(cu.max(), value(2 * size() - 1));
+    unsigned w = width(offset_type(hi) - offset_type(lo));
+
+    if (lo != base() || w > width())
+      recode(lo, std::max(w, width()));
+  }
+
+  // Narrow the width to the range of the intervals, if it can.  We
+  // keep the base otherwise, since the offsets from it still fit.
+  void
+  narrow()
+  {
+    T lo = value(0);
+    T hi = value(2 * size() - 1);
+
+    if (unsigned w = width(offset_type(hi) - offset_type(lo)); w < width())
+      recode(lo, w);
+  }
+
+  // Recode the offsets with new base b and width w.  The new data is
+  // allocated anew, so the memory of a wider width is released.
+  void
+  recode(T b, unsigned w)
+  {
+    std::vector<T> v(2 * size());
+    for (std::size_t e = 0; e < v.size(); ++e)
+      v[e] = value(e);
+
+    decltype(m_data) d(header + v.size() * w);
+    d[0] = w;
+    std::memcpy(d.data() + 1, &b, sizeof(b));
+    m_data.swap(d);
+
+    for (std::size_t e = 0; e < v.size(); ++e)
+      set(e, v[e]);
+  }
+};
+
+#endif // COMPACT_HPP
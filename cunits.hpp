@@ -4,8 +4,10 @@
 #include <cassert>
 #include <compare>
 #include <concepts>
+#include <cstdint>
 #include <iostream>
 #include <list>
+#include <type_traits>
 
 // Describes a resource interval [min, max), i.e., min is included,
 // and max is not.  The interval endpoints are totally ordered.
@@ -138,10 +140,39 @@ public:
 //
 // * i == j otherwise.
 
+// For integral endpoints of at most 32 bits, we pack an interval into
+// a single 64-bit key, so that i < j iff key(i) < key(j), and then
+// <=> is a single integer comparison.  The key has the complemented
+// min in the upper half (the greater min, the less the interval), and
+// the max in the lower half (the greater max, the greater the
+// interval).  The signed endpoints get their sign bit flipped, so
+// that they compare as unsigned.
+//
+// Since min < max, the max of any interval is not the lowest value,
+// and so the key is never 0.
+
+template <typename T>
+concept packable = std::integral<T> && !std::same_as<T, bool> &&
+  sizeof(T) <= 4;
+
+template <packable T>
+constexpr std::uint64_t
+packed_key(const cunits<T> &i)
+{
+  using U = std::make_unsigned_t<T>;
+  constexpr unsigned W = 8 * sizeof(T);
+  constexpr U sign = std::is_signed_v<T> ? U(U(1) << (W - 1)) : U(0);
+
+  return std::uint64_t(U(~(U(i.min()) ^ sign))) << W | U(U(i.max()) ^ sign);
+}
+
 template<typename T>
 constexpr auto
 operator <=> (const cunits<T> &i, const cunits<T> &j)
 {
+  if constexpr (packable<T>)
+    return packed_key(i) <=> packed_key(j);
+
   // Compare the lower endpoints first.
   if (i.min() < j.min())
     return std::strong_ordering::greater;
@@ -211,4 +242,20 @@ operator >> (std::istream &in, cunits<T> &cu)
   return in;
 }
 
+// The pointer type of the iterators that yield cunits by value, e.g.,
+// of the stores that decode the intervals: operator -> needs a
+// pointer, and these iterators have a value only, so the pointer
+// keeps the value.
+template <typename T>
+struct cunits_pointer
+{
+  cunits<T> m_v;
+
+  const cunits<T> *
+  operator -> () const
+  {
+    return &m_v;
+  }
+};
+
 #endif // CUNITS_HPP
@@ -0,0 +1,336 @@
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+#include "cunits.hpp"
+#include "sunits.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+
+// Replication of sunits with deltas.  A delta is an insert or a
+// remove of an interval with a sequence number.  The primary keeps
+// its sunits in logged_sunits, which records the deltas, and sends a
+// replica a checkpoint (the sunits at some sequence number) followed
+// by the deltas after it.  The replica applies the deltas in order,
+// and so the bytes sent are proportional to the changes, not to the
+// size of the sunits.
+//
+// The binary format is made of records:
+//
+// * the checkpoint: 'C', the sequence number, the number of
+//   intervals, and then for every interval the distance of its min
+//   from the max of the previous interval (or its min for the first
+//   interval), and its size,
+//
+// * the delta: 'D', the sequence number, 'i' for insert or 'r' for
+//   remove, the min, and the size.
+//
+// The numbers are unsigned LEB128 varints, so small numbers take a
+// byte.  The signed endpoints are zigzag-encoded, so that the small
+// negative numbers take a byte too.
+
+// Write an unsigned LEB128 varint.
+inline std::ostream &
+write_varint(std::ostream &out, std::uint64_t v)
+{
+  for (; v >= 0x80; v >>= 7)
+    out.put(char(v | 0x80));
+  out.put(char(v));
+  return out;
+}
+
+// Read an unsigned LEB128 varint.
+inline std::istream &
+read_varint(std::istream &in, std::uint64_t &v)
+{
+  v = 0;
+
+  for (unsigned s = 0; s < 64; s += 7)
+    {
+      int c = in.get();
+      if (c == std::char_traits<char>::eof())
+        break;
+      // The 10th byte has the highest bit only.
+      if (s == 63 && (c & 0x7f) > 1)
+        break;
+      v |= std::uint64_t(c & 0x7f) << s;
+      if (!(c & 0x80))
+        return in;
+    }
+
+  in.setstate(std::ios::failbit);
+  return in;
+}
+
+// Encode an endpoint as an unsigned number.
+template <std::integral T>
+std::uint64_t
+zigzag(T v)
+{
+  if constexpr (std::is_signed_v<T>)
+    return (std::uint64_t(v) << 1) ^ std::uint64_t(v < 0 ? -1 : 0);
+  else
+    return v;
+}
+
+template <std::integral T>
+T
+unzigzag(std::uint64_t u)
+{
+  if constexpr (std::is_signed_v<T>)
+    return T((u >> 1) ^ -(u & 1));
+  else
+    return T(u);
+}
+
+// Decode endpoint u into v, unless it doesn't fit T.
+template <std::integral T>
+bool
+decode_endpoint(std::uint64_t u, T &v)
+{
+  v = unzigzag<T>(u);
+  return zigzag(v) == u;
+}
+
+// Set e to v + d, unless d is 0 or v + d overflows T.  We get the max
+// of an interval from its min and its size, and the min of the next
+// interval from the max of the previous one and the distance, and so
+// the intervals read are proper and in order.
+template <std::integral T>
+bool
+advance_endpoint(T v, std::uint64_t d, T &e)
+{
+  using U = std::make_unsigned_t<T>;
+
+  if (!d || d > U(U(std::numeric_limits<T>::max()) - U(v)))
+    return false;
+
+  e = T(U(U(v) + d));
+  return true;
+}
+
+enum class delta_op: char {insert = 'i', remove = 'r'};
+
+template <typename T>
+struct delta
+{
+  std::uint64_t seq;
+  delta_op op;
+  cunits<T> cu;
+
+  bool operator == (const delta &) const = default;
+};
+
+template <typename T, typename C>
+void
+apply_delta(sunits<T, C> &su, const delta<T> &d)
+{
+  if (d.op == delta_op::insert)
+    su.insert(d.cu);
+  else
+    su.remove(d.cu);
+}
+
+// The sunits that records the deltas of insert and remove.  The log
+// keeps the deltas after the sequence number given to truncate().
+template <std::integral T, typename C = vector_store<T>>
+class logged_sunits
+{
+  sunits<T, C> m_su;
+
+  // The sequence number of the last delta.
+  std::uint64_t m_seq = 0;
+
+  // The deltas with the sequence numbers (m_seq - m_log.size(),
+  // m_seq].
+  std::vector<delta<T>> m_log;
+
+public:
+  logged_sunits() = default;
+
+  // Start with su at sequence number seq, e.g., from a checkpoint.
+  logged_sunits(sunits<T, C> su, std::uint64_t seq):
+    m_su(std::move(su)), m_seq(seq)
+  {
+  }
+
+  const sunits<T, C> &
+  units() const
+  {
+    return m_su;
+  }
+
+  std::uint64_t
+  seq() const
+  {
+    return m_seq;
+  }
+
+  void
+  insert(const cunits<T> &cu)
+  {
+    apply({m_seq + 1, delta_op::insert, cu});
+  }
+
+  void
+  remove(const cunits<T> &cu)
+  {
+    apply({m_seq + 1, delta_op::remove, cu});
+  }
+
+  // Apply the delta of the primary.  The deltas must come in order.
+  void
+  apply(const delta<T> &d)
+  {
+    assert(d.seq == m_seq + 1);
+    apply_delta(m_su, d);
+    m_log.push_back(d);
+    m_seq = d.seq;
+  }
+
+  // The deltas after sequence number seq.  They must be still in the
+  // log.
+  auto
+  deltas(std::uint64_t seq) const
+  {
+    assert(m_seq - m_log.size() <= seq && seq <= m_seq);
+    return std::ranges::subrange(m_log.end() - (m_seq - seq), m_log.end());
+  }
+
+  // Forget the deltas up to sequence number seq, e.g., when the
+  // replicas have applied them.
+  void
+  truncate(std::uint64_t seq)
+  {
+    auto first = m_seq - m_log.size();
+    if (seq > first)
+      m_log.erase(m_log.begin(),
+                  m_log.begin() + (std::min(seq, m_seq) - first));
+  }
+};
+
+template <std::integral T, typename C>
+std::ostream &
+write_checkpoint(std::ostream &out, const sunits<T, C> &su,
+                 std::uint64_t seq)
+{
+  using U = std::make_unsigned_t<T>;
+
+  out.put('C');
+  write_varint(out, seq);
+  write_varint(out, std::ranges::distance(su.begin(), su.end()));
+
+  bool first = true;
+  U prev = 0;
+
+  for (const auto &cu: su)
+    {
+      write_varint(out, first ? zigzag(cu.min()) : U(U(cu.min()) - prev));
+      write_varint(out, U(U(cu.max()) - U(cu.min())));
+      prev = cu.max();
+      first = false;
+    }
+
+  return out;
+}
+
+template <std::integral T, typename C>
+std::ostream &
+write_checkpoint(std::ostream &out, const logged_sunits<T, C> &ls)
+{
+  return write_checkpoint(out, ls.units(), ls.seq());
+}
+
+template <typename T>
+std::ostream &
+write_delta(std::ostream &out, const delta<T> &d)
+{
+  using U = std::make_unsigned_t<T>;
+
+  out.put('D');
+  write_varint(out, d.seq);
+  out.put(char(d.op));
+  write_varint(out, zigzag(d.cu.min()));
+  write_varint(out, U(U(d.cu.max()) - U(d.cu.min())));
+
+  return out;
+}
+
+// Write the deltas after sequence number seq.
+template <std::integral T, typename C>
+std::ostream &
+write_deltas(std::ostream &out, const logged_sunits<T, C> &ls,
+             std::uint64_t seq)
+{
+  for (const auto &d: ls.deltas(seq))
+    write_delta(out, d);
+
+  return out;
+}
+
+// Read the checkpoint into su, which gets cleared, and seq.
+template <std::integral T, typename C>
+std::istream &
+read_checkpoint(std::istream &in, sunits<T, C> &su, std::uint64_t &seq)
+{
+  std::uint64_t n;
+
+  if (in.get() != 'C' || !read_varint(in, seq) || !read_varint(in, n))
+    {
+      in.setstate(std::ios::failbit);
+      return in;
+    }
+
+  su = sunits<T, C>();
+  T prev = T();
+
+  for (std::uint64_t i = 0; i < n; ++i)
+    {
+      std::uint64_t d, s;
+      T min;
+
+      // The intervals can neither be empty nor touch.
+      if (!read_varint(in, d) || !read_varint(in, s) ||
+          !(i ? advance_endpoint(prev, d, min) : decode_endpoint(d, min)) ||
+          !advance_endpoint(min, s, prev))
+        {
+          in.setstate(std::ios::failbit);
+          break;
+        }
+
+      su.insert({min, prev});
+    }
+
+  return in;
+}
+
+template <typename T>
+std::istream &
+read_delta(std::istream &in, delta<T> &d)
+{
+  std::uint64_t seq, min, s;
+  T m, x;
+  int op;
+
+  if (in.get() != 'D' || !read_varint(in, seq) ||
+      ((op = in.get()) != 'i' && op != 'r') ||
+      !read_varint(in, min) || !read_varint(in, s) ||
+      !decode_endpoint(min, m) || !advance_endpoint(m, s, x))
+    {
+      in.setstate(std::ios::failbit);
+      return in;
+    }
+
+  d = {seq, delta_op(op), cunits<T>(m, x)};
+
+  return in;
+}
+
+#endif // DELTA_HPP
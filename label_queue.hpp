@@ -0,0 +1,326 @@
+#ifndef LABEL_QUEUE_HPP
+#define LABEL_QUEUE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// The priority queue of labels, e.g., of (cost, sunits) labels of a
+// routing and spectrum assignment algorithm.  We process the labels
+// of the lowest cost first, and of the same cost the labels with the
+// better (i.e., greater) sunits first, as cunits.hpp explains.  The
+// labels with the same cost and equal sunits come in the order they
+// were pushed.
+//
+// The queue is monotone, as Dijkstra needs: we cannot push a label
+// of a cost lower than the cost of the last label popped.  Then we
+// use a radix heap: bucket b > 0 keeps the labels whose cost differs
+// from the last cost popped first at bit b - 1, and bucket 0 keeps
+// the labels of the last cost, ordered by the sunits with a binary
+// heap.  When bucket 0 runs out, we take the lowest cost of the first
+// non-empty bucket as the last cost, and redistribute that bucket
+// among the lower buckets.  A label moves to the lower buckets only,
+// so push and pop take O(log C) amortized time, where C is the range
+// of the cost type, plus the time of the heap of bucket 0.
+//
+// The labels stay in the slots of a pool, and the buckets keep the
+// entries that refer to the slots, and so the sunits are never
+// copied: push moves the sunits in, and pop moves them out.  A handle
+// identifies a label until the label gets popped or erased.
+//
+// We decrease the cost of a label with lazy deletion: we push a new
+// entry, and the old one becomes stale, i.e., its sequence number is
+// not the sequence number of the slot anymore.  The stale entries are
+// dropped when found.  A slot is reused when no entry refers to it.
+
+template <typename S, std::unsigned_integral Cost = unsigned>
+class label_queue
+{
+public:
+  using label_type = S;
+  using cost_type = Cost;
+  using handle = std::size_t;
+
+private:
+  struct slot
+  {
+    Cost m_cost;
+    S m_label;
+    // The sequence number of the current entry, or 0 if there is
+    // none, i.e., the label was popped or erased.
+    std::uint64_t m_seq;
+    // The number of entries that refer to the slot.
+    unsigned m_refs;
+  };
+
+  struct entry
+  {
+    Cost m_cost;
+    handle m_h;
+    std::uint64_t m_seq;
+  };
+
+  static constexpr unsigned B = std::numeric_limits<Cost>::digits + 1;
+
+  std::vector<slot> m_slots;
+  std::vector<handle> m_free;
+  std::vector<entry> m_buckets[B];
+
+  // The cost of the last label popped.
+  Cost m_last = 0;
+
+  // The number of entries pushed.
+  std::uint64_t m_seq = 0;
+
+  // The number of labels.
+  std::size_t m_n = 0;
+
+public:
+  bool
+  empty() const
+  {
+    return !m_n;
+  }
+
+  std::size_t
+  size() const
+  {
+    return m_n;
+  }
+
+  // Push the label of cost c, which cannot be lower than the cost of
+  // the last label popped.
+  handle
+  push(Cost c, S label)
+  {
+    handle h;
+
+    if (m_free.empty())
+      {
+        h = m_slots.size();
+        m_slots.push_back({c, std::move(label), 0, 0});
+      }
+    else
+      {
+        h = m_free.back();
+        m_free.pop_back();
+        m_slots[h].m_cost = c;
+        m_slots[h].m_label = std::move(label);
+      }
+
+    ++m_n;
+    enqueue(h, c);
+    return h;
+  }
+
+  // The handle of the label to process first.  The queue cannot be
+  // empty.
+  handle
+  top()
+  {
+    assert(!empty());
+    settle();
+    return m_buckets[0].front().m_h;
+  }
+
+  Cost
+  cost(handle h) const
+  {
+    assert(live(h));
+    return m_slots[h].m_cost;
+  }
+
+  const S &
+  label(handle h) const
+  {
+    assert(live(h));
+    return m_slots[h].m_label;
+  }
+
+  // Pop the label to process first.  The queue cannot be empty.
+  std::pair<Cost, S>
+  pop()
+  {
+    assert(!empty());
+    settle();
+    entry e = take_top();
+
+    auto &s = m_slots[e.m_h];
+    std::pair<Cost, S> ret(s.m_cost, std::move(s.m_label));
+    s.m_seq = 0;
+    --m_n;
+    release(e);
+
+    return ret;
+  }
+
+  // Decrease the cost of label h to c, which cannot be lower than the
+  // cost of the last label popped.
+  void
+  decrease(handle h, Cost c)
+  {
+    assert(live(h));
+    assert(m_last <= c && c <= m_slots[h].m_cost);
+
+    if (c < m_slots[h].m_cost)
+      {
+        m_slots[h].m_cost = c;
+        enqueue(h, c);
+      }
+  }
+
+  // Erase label h.
+  void
+  erase(handle h)
+  {
+    assert(live(h));
+    m_slots[h].m_seq = 0;
+    --m_n;
+  }
+
+private:
+  bool
+  live(handle h) const
+  {
+    return h < m_slots.size() && m_slots[h].m_seq;
+  }
+
+  bool
+  stale(const entry &e) const
+  {
+    return m_slots[e.m_h].m_seq != e.m_seq;
+  }
+
+  unsigned
+  bucket(Cost c) const
+  {
+    return std::bit_width(Cost(c ^ m_last));
+  }
+
+  // Is entry a processed after entry b?  For the heap of bucket 0,
+  // where the costs are equal.
+  bool
+  after(const entry &a, const entry &b) const
+  {
+    const S &la = m_slots[a.m_h].m_label;
+    const S &lb = m_slots[b.m_h].m_label;
+
+    if (auto o = la <=> lb; o != 0)
+      return o < 0;
+
+    return a.m_seq > b.m_seq;
+  }
+
+  auto
+  heap_order()
+  {
+    return [this](const entry &a, const entry &b) {return after(a, b);};
+  }
+
+  // Push the entry of slot h with cost c, which makes the previous
+  // entry of the slot stale.
+  void
+  enqueue(handle h, Cost c)
+  {
+    assert(m_last <= c);
+
+    auto &s = m_slots[h];
+    s.m_seq = ++m_seq;
+    ++s.m_refs;
+
+    auto b = bucket(c);
+    m_buckets[b].push_back({c, h, s.m_seq});
+    if (!b)
+      std::push_heap(m_buckets[0].begin(), m_buckets[0].end(),
+                     heap_order());
+  }
+
+  // Release the entry.
+  void
+  release(const entry &e)
+  {
+    if (!--m_slots[e.m_h].m_refs)
+      {
+        // Free the sunits now.
+        m_slots[e.m_h].m_label = S();
+        m_free.push_back(e.m_h);
+      }
+  }
+
+  // Take the top entry of bucket 0.
+  entry
+  take_top()
+  {
+    auto &b0 = m_buckets[0];
+    std::pop_heap(b0.begin(), b0.end(), heap_order());
+    entry e = b0.back();
+    b0.pop_back();
+    return e;
+  }
+
+  // Make the top of bucket 0 the entry of the label to process first.
+  // We drop the stale entries, which can be in bucket 0 after erase,
+  // and refill bucket 0 when it runs out.
+  void
+  settle()
+  {
+    while (true)
+      {
+        auto &b0 = m_buckets[0];
+
+        while (!b0.empty() && stale(b0.front()))
+          release(take_top());
+
+        if (!b0.empty() || !refill())
+          return;
+      }
+  }
+
+  // Redistribute the first non-empty bucket.  Return false if there
+  // is none, which breaks the precondition of the callers.
+  bool
+  refill()
+  {
+    unsigned b = 1;
+    while (b < B && m_buckets[b].empty())
+      ++b;
+
+    assert(b < B);
+    if (b == B)
+      return false;
+
+    auto v = std::move(m_buckets[b]);
+    m_buckets[b].clear();
+
+    // Drop the stale entries, and find the lowest cost.
+    auto i = std::remove_if(v.begin(), v.end(), [this](const entry &e)
+    {
+      if (!stale(e))
+        return false;
+      release(e);
+      return true;
+    });
+    v.erase(i, v.end());
+
+    if (v.empty())
+      return true;
+
+    m_last = std::min_element(v.begin(), v.end(),
+                              [](const entry &a, const entry &b)
+                              {return a.m_cost < b.m_cost;})->m_cost;
+
+    for (const auto &e: v)
+      m_buckets[bucket(e.m_cost)].push_back(e);
+
+    std::make_heap(m_buckets[0].begin(), m_buckets[0].end(), heap_order());
+    return true;
+  }
+};
+
+#endif // LABEL_QUEUE_HPP
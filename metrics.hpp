@@ -0,0 +1,167 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <utility>
+
+// The store of sunits that keeps the fragmentation metrics up to
+// date.  It wraps store C (e.g., vector_store<T>) and updates the
+// metrics whenever an interval gets inserted into or erased from C.
+// Since sunits changes its store with these operations only, the
+// metrics follow insert, remove and the merging of intervals.
+//
+// Every change costs O(log n) time, where n is the number of
+// distinct sizes of the intervals, and reading the metrics costs
+// O(1) time.  Use it like this:
+//
+// sunits<unsigned, metrics_store<vector_store<unsigned>>> su;
+// su.store().largest();
+//
+// We call the intervals blocks, since we usually keep the free units
+// in sunits.
+
+template <typename C>
+class metrics_store: public C
+{
+public:
+  using typename C::value_type;
+  using typename C::const_iterator;
+  using units_type = decltype(std::declval<value_type>().size());
+
+private:
+  // The number of units in all blocks.
+  units_type m_units = units_type();
+
+  // The sum of s ln s over the block sizes s, for the entropy.
+  double m_sls = 0;
+
+  // The number of blocks of a given size.
+  std::map<units_type, std::size_t> m_sizes;
+
+public:
+  auto
+  insert(const_iterator i, const value_type &cu)
+  {
+    add(cu.size());
+    return C::insert(i, cu);
+  }
+
+  auto
+  erase(const_iterator i)
+  {
+    subtract((*i).size());
+    return C::erase(i);
+  }
+
+  auto
+  erase(const_iterator i, const_iterator j)
+  {
+    for (auto k = i; k != j; ++k)
+      subtract((*k).size());
+    return C::erase(i, j);
+  }
+
+  void
+  clear()
+  {
+    C::clear();
+    m_units = units_type();
+    m_sls = 0;
+    m_sizes.clear();
+  }
+
+  // The metrics follow from the intervals.
+  bool
+  operator == (const metrics_store &s) const
+  {
+    return static_cast<const C &>(*this) == s;
+  }
+
+  // The number of blocks.
+  std::size_t
+  blocks() const
+  {
+    return C::size();
+  }
+
+  // The number of units in all blocks.
+  units_type
+  units() const
+  {
+    return m_units;
+  }
+
+  // The size of the largest block, or 0 if there are no blocks.
+  units_type
+  largest() const
+  {
+    return m_sizes.empty() ? units_type() : m_sizes.rbegin()->first;
+  }
+
+  // The histogram of the block sizes: the number of blocks of a given
+  // size.
+  const std::map<units_type, std::size_t> &
+  histogram() const
+  {
+    return m_sizes;
+  }
+
+  // The Shannon entropy (in nats) of the distribution of the units
+  // among the blocks: sum of -(s / S) ln (s / S) over the block sizes
+  // s, where S is the number of units.  It's 0 for a single block,
+  // and grows as the units spread over more blocks.
+  double
+  entropy() const
+  {
+    if (!m_units)
+      return 0;
+
+    double S = m_units;
+    // Rewritten as: ln S - sum(s ln s) / S.
+    return std::max(0.0, std::log(S) - m_sls / S);
+  }
+
+  // The external fragmentation: 1 - (the largest block) / (the number
+  // of units).  It's 0 for a single block, and approaches 1 as the
+  // units spread over many small blocks.
+  double
+  fragmentation() const
+  {
+    return m_units ? 1 - double(largest()) / double(m_units) : 0;
+  }
+
+private:
+  static double
+  sls(units_type s)
+  {
+    return double(s) * std::log(double(s));
+  }
+
+  void
+  add(units_type s)
+  {
+    m_units += s;
+    m_sls += sls(s);
+    ++m_sizes[s];
+  }
+
+  void
+  subtract(units_type s)
+  {
+    m_units -= s;
+    m_sls -= sls(s);
+
+    auto i = m_sizes.find(s);
+    if (!--i->second)
+      m_sizes.erase(i);
+
+    // Avoid the accumulation of the rounding errors.
+    if (m_sizes.empty())
+      m_sls = 0;
+  }
+};
+
+#endif // METRICS_HPP
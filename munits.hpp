@@ -0,0 +1,218 @@
+#ifndef MUNITS_HPP
+#define MUNITS_HPP
+
+#include "cunits.hpp"
+#include "sunits.hpp"
+
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Two-dimensional units: the units (slots) [0, slots) of a number of
+// cores, e.g., of a multi-core fibre.  A block is a set of cores
+// (given with a bit mask) times an interval of slots.
+//
+// We keep the units slot-major: for every slot there is a mask (a
+// bit plane) of the cores where the slot is included.  Then the
+// operations on a block take O(size of the interval) word
+// operations, regardless of the number of cores, and we can find a
+// block of k cores in a single pass over the slots.
+//
+// As with sunits, we offer only the minimal functionality: insert a
+// block that in no part is already included, and remove a block that
+// is already included.  There are at most 64 cores.
+
+template <std::integral T>
+class munits
+{
+public:
+  using mask_type = std::uint64_t;
+  using data_type = cunits<T>;
+
+private:
+  unsigned m_cores;
+  std::vector<mask_type> m_planes;
+
+public:
+  // Nothing is included.
+  munits(unsigned cores, T slots): m_cores(cores), m_planes(slots)
+  {
+    assert(0 < cores && cores <= 64);
+  }
+
+  // Core c has the units of v[c].
+  template <typename C>
+  munits(const std::vector<sunits<T, C>> &v, T slots):
+    munits(v.size(), slots)
+  {
+    for (unsigned c = 0; c < v.size(); ++c)
+      for (const auto &cu: v[c])
+        insert(mask(c), cu);
+  }
+
+  bool operator == (const munits &) const = default;
+
+  unsigned
+  cores() const
+  {
+    return m_cores;
+  }
+
+  T
+  slots() const
+  {
+    return m_planes.size();
+  }
+
+  // The mask of all cores.
+  mask_type
+  all() const
+  {
+    return m_cores == 64 ? ~mask_type() : (mask_type(1) << m_cores) - 1;
+  }
+
+  // The mask of core c.
+  static mask_type
+  mask(unsigned c)
+  {
+    return mask_type(1) << c;
+  }
+
+  // The mask of the cores where slot s is included.
+  mask_type
+  plane(T s) const
+  {
+    return m_planes[s];
+  }
+
+  // Insert block cores x cu.  No part of it can already be included.
+  void
+  insert(mask_type cores, const data_type &cu)
+  {
+    assert(in_range(cores, cu));
+
+    for (T s = cu.min(); s < cu.max(); ++s)
+      {
+        assert(!(m_planes[s] & cores));
+        m_planes[s] |= cores;
+      }
+  }
+
+  // Remove block cores x cu.  The block must be already included.
+  void
+  remove(mask_type cores, const data_type &cu)
+  {
+    assert(in_range(cores, cu));
+
+    for (T s = cu.min(); s < cu.max(); ++s)
+      {
+        assert((m_planes[s] & cores) == cores);
+        m_planes[s] &= ~cores;
+      }
+  }
+
+  // The units of core c.
+  sunits<T>
+  core(unsigned c) const
+  {
+    return common(mask(c));
+  }
+
+  // The units included in all the cores.
+  sunits<T>
+  common(mask_type cores) const
+  {
+    sunits<T> ret;
+
+    for (T s = 0; s < slots();)
+      if ((m_planes[s] & cores) == cores)
+        {
+          T e = s;
+          while (++e < slots() && (m_planes[e] & cores) == cores);
+          ret.insert({s, e});
+          s = e;
+        }
+      else
+        ++s;
+
+    return ret;
+  }
+
+  // Find the first (with the lowest slots) block of n slots on k
+  // cores.  We return the k lowest cores available throughout the
+  // slots.
+  //
+  // We need the AND of the planes in every window of n slots.  We
+  // use the van Herk-Gil-Werman algorithm: we split the slots into
+  // chunks of n, and compute the AND from the chunk start (prefix)
+  // and to the chunk end (suffix).  A window spans at most two
+  // chunks, so its AND is the suffix of its first slot AND the
+  // prefix of its last slot.  It takes O(slots) time, regardless of
+  // n.
+  std::optional<std::pair<mask_type, data_type>>
+  fit(unsigned k, T n) const
+  {
+    assert(0 < k && k <= m_cores && 0 < n);
+
+    T S = slots();
+    if (n > S)
+      return std::nullopt;
+
+    std::vector<mask_type> pre(S), suf(S);
+
+    for (T s = 0; s < S; ++s)
+      pre[s] = s % n ? pre[s - 1] & m_planes[s] : m_planes[s];
+
+    for (T s = S; s-- > 0;)
+      suf[s] = (s + 1) % n && s + 1 < S ?
+        suf[s + 1] & m_planes[s] : m_planes[s];
+
+    for (T s = 0; s + n <= S; ++s)
+      if (mask_type m = suf[s] & pre[s + n - 1];
+          unsigned(std::popcount(m)) >= k)
+        {
+          // Take the k lowest cores.
+          mask_type r = 0;
+          for (unsigned i = 0; i < k; ++i)
+            {
+              r |= m & -m;
+              m &= m - 1;
+            }
+
+          return std::pair(r, data_type(s, s + n));
+        }
+
+    return std::nullopt;
+  }
+
+private:
+  bool
+  in_range(mask_type cores, const data_type &cu) const
+  {
+    return cores && !(cores & ~all()) && T() <= cu.min() &&
+      cu.max() <= slots();
+  }
+};
+
+// Block cores x cu has to be included.  The slots outside [0, slots)
+// are not included.
+template <typename T>
+bool
+includes(const munits<T> &mu, typename munits<T>::mask_type cores,
+         const cunits<T> &cu)
+{
+  if (cu.min() < T() || cu.max() > mu.slots())
+    return false;
+
+  for (T s = cu.min(); s < cu.max(); ++s)
+    if ((mu.plane(s) & cores) != cores)
+      return false;
+
+  return true;
+}
+
+#endif // MUNITS_HPP
@@ -0,0 +1,167 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include "cunits.hpp"
+#include "stats.hpp"
+#include "sunits.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+// The non-owning store of sunits: the span of intervals kept
+// elsewhere, e.g., in sunits_pool.  The sunits with this store can be
+// queried and compared, but not changed.  The results of the
+// operations on them (e.g., of intersection) have the vector store.
+template <typename T>
+class span_store: public std::span<const cunits<T>>
+{
+  using base = std::span<const cunits<T>>;
+
+public:
+  using value_type = cunits<T>;
+  using const_iterator = typename base::iterator;
+
+  using base::base;
+
+  bool
+  operator == (const span_store &s) const
+  {
+    return std::ranges::equal(*this, s);
+  }
+};
+
+template <typename T>
+struct owning_store<span_store<T>>
+{
+  using type = vector_store<T>;
+};
+
+// The pool of many sunits kept contiguously in the CSR (compressed
+// sparse row) layout: the intervals of all sunits in a single array,
+// and the offsets of the intervals of every sunits in the other, so
+// that sunits k has the intervals [offsets[k], offsets[k + 1]).  That
+// takes two allocations for the whole pool instead of one per sunits,
+// and the sweeps over all sunits go through the memory sequentially.
+//
+// The pool hands out the sunits as views: sunits with span_store.
+// The views are invalidated by the changes of the pool.  The sunits
+// are appended, and they cannot be changed in place, since they
+// would have to shift the intervals of the sunits that follow.
+
+template <std::totally_ordered T>
+class sunits_pool
+{
+public:
+  using view_type = sunits<T, span_store<T>>;
+
+private:
+  std::vector<cunits<T>, units_allocator<cunits<T>>> m_units;
+  std::vector<std::size_t> m_offsets = {0};
+
+public:
+  // The number of sunits.
+  std::size_t
+  size() const
+  {
+    return m_offsets.size() - 1;
+  }
+
+  bool
+  empty() const
+  {
+    return !size();
+  }
+
+  // The sunits k.
+  view_type
+  operator[](std::size_t k) const
+  {
+    assert(k < size());
+    return view_type(span_store<T>(m_units.data() + m_offsets[k],
+                                   m_units.data() + m_offsets[k + 1]));
+  }
+
+  // Reserve the memory for the given numbers of sunits and intervals.
+  void
+  reserve(std::size_t sets, std::size_t intervals)
+  {
+    m_offsets.reserve(sets + 1);
+    m_units.reserve(intervals);
+  }
+
+  // Append sunits su, and return its index.
+  template <typename C>
+  std::size_t
+  append(const sunits<T, C> &su)
+  {
+    m_units.insert(m_units.end(), su.begin(), su.end());
+    m_offsets.push_back(m_units.size());
+    return size() - 1;
+  }
+
+  // Remove the sunits for which the predicate of their view is true,
+  // and keep the order of the others.  We compact the intervals in a
+  // single pass.  Return the number of the sunits removed.
+  template <typename P>
+  std::size_t
+  erase_if(P p)
+  {
+    std::size_t n = size(), k = 0, u = 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        auto first = m_offsets[i], last = m_offsets[i + 1];
+
+        if (p(std::as_const(*this)[i]))
+          continue;
+
+        // Until the first sunits removed, the intervals stay in place,
+        // and then they move left, so the ranges never overlap.
+        if (u != first)
+          std::move(m_units.begin() + first, m_units.begin() + last,
+                    m_units.begin() + u);
+        u += last - first;
+        m_offsets[++k] = u;
+      }
+
+    m_units.erase(m_units.begin() + u, m_units.end());
+    m_offsets.resize(k + 1);
+    return n - k;
+  }
+
+  void
+  clear()
+  {
+    m_units.clear();
+    m_offsets.assign(1, 0);
+  }
+
+  // Call f(k, view) for every sunits k in order, for the bulk scans.
+  template <typename F>
+  void
+  for_each(F f) const
+  {
+    for (std::size_t k = 0; k < size(); ++k)
+      f(k, (*this)[k]);
+  }
+
+  // The intervals of all sunits, and their offsets.
+  const auto &
+  units() const
+  {
+    return m_units;
+  }
+
+  const std::vector<std::size_t> &
+  offsets() const
+  {
+    return m_offsets;
+  }
+};
+
+#endif // POOL_HPP
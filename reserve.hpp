@@ -0,0 +1,281 @@
+#ifndef RESERVE_HPP
+#define RESERVE_HPP
+
+#include "cunits.hpp"
+#include "sunits.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// All-or-nothing reservations on sunits shared between threads, e.g.,
+// removing the same cunits from the free units of every link along a
+// path to set up a lightpath.
+//
+// A shared_sunits keeps its sunits as an immutable snapshot, which
+// the readers and the transactions copy the pointer of, and a
+// version, which is even when the sunits are not being changed, and
+// odd when a transaction is publishing a new snapshot.
+//
+// A reservation collects the operations (remove and insert), and
+// commits them with optimistic concurrency control:
+//
+// * read the version and the snapshot of every shared sunits,
+//
+// * validate the operations on the snapshots (remove needs the
+//   interval included, insert needs it not overlapping), and build
+//   the new snapshots -- no versions are taken so far,
+//
+// * in the order of the addresses, change every version v to v + 1
+//   with compare-and-swap, and if any version changed in the meantime,
+//   undo and retry after a backoff,
+//
+// * swap the new snapshots in, change every version to v + 2, and
+//   only then release the old snapshots.
+//
+// While the versions are odd, a reservation only swaps the pointers:
+// it neither allocates nor frees, so the versions are held briefly.
+// Versions are taken in the same order, and never waited for, so
+// there are no deadlocks, and an uncontended reservation never waits.
+//
+// The reads are not lock-free, though, and neither is the
+// publication.  The pointer to the snapshot is guarded by a mutex,
+// which units() and the swap take even without contention, and hold
+// for the copy of the pointer only, i.e., for an update of the
+// reference count.  The optimistic concurrency control is of the
+// reservations, which never wait for one another, and not of the
+// reads.  We don't use std::atomic<std::shared_ptr> instead, since
+// it's not lock-free either (in libstdc++ as of GCC 12, it's guarded
+// by a spin lock in the pointer, and is_lock_free() is false), and
+// the thread sanitizer doesn't see that lock.
+//
+// A reservation that committed is empty, and collects the operations
+// of the next commit.  A reservation that failed keeps its operations,
+// so that it can be committed again.
+
+template <typename T, typename C = vector_store<T>>
+class shared_sunits
+{
+public:
+  using sunits_type = sunits<T, C>;
+  using snapshot_type = std::shared_ptr<const sunits_type>;
+
+private:
+  snapshot_type m_su;
+  mutable std::mutex m_mutex;
+  std::atomic<std::uint64_t> m_version = 0;
+
+  template <typename, typename>
+  friend class reservation;
+
+public:
+  shared_sunits(sunits_type su = sunits_type()):
+    m_su(std::make_shared<const sunits_type>(std::move(su)))
+  {
+  }
+
+  // The sunits as of now.  They don't change, and the newer sunits
+  // are published in a new snapshot.
+  snapshot_type
+  units() const
+  {
+    std::lock_guard lock(m_mutex);
+    return m_su;
+  }
+
+  // The number of changes times 2, plus 1 if a change is being
+  // published.
+  std::uint64_t
+  version() const
+  {
+    return m_version.load(std::memory_order_acquire);
+  }
+};
+
+template <typename T, typename C = vector_store<T>>
+class reservation
+{
+public:
+  using shared_type = shared_sunits<T, C>;
+  using sunits_type = sunits<T, C>;
+  using snapshot_type = typename shared_type::snapshot_type;
+
+private:
+  struct operation
+  {
+    shared_type *m_s;
+    cunits<T> m_cu;
+    bool m_remove;
+  };
+
+  std::vector<operation> m_ops;
+
+  // The number of attempts of the last commit.
+  unsigned m_attempts = 0;
+
+public:
+  // Remove cu from s.  Then cu must be included in s.
+  reservation &
+  remove(shared_type &s, const cunits<T> &cu)
+  {
+    m_ops.push_back({&s, cu, true});
+    return *this;
+  }
+
+  // Insert cu into s.  Then cu cannot overlap with s.
+  reservation &
+  insert(shared_type &s, const cunits<T> &cu)
+  {
+    m_ops.push_back({&s, cu, false});
+    return *this;
+  }
+
+  // Commit all the operations, or none if some operation is not
+  // valid.  The operations on the same shared sunits are applied in
+  // the order given.  The operations committed are cleared.
+  bool
+  commit()
+  {
+    // Group the operations by the shared sunits in the order of the
+    // addresses, keeping the order of the operations of a group.
+    std::stable_sort(m_ops.begin(), m_ops.end(),
+                     [](const auto &a, const auto &b)
+                     {return std::less<>()(a.m_s, b.m_s);});
+
+    // The shared sunits, their versions and new snapshots.
+    struct change
+    {
+      shared_type *m_s;
+      std::uint64_t m_v;
+      snapshot_type m_su;
+    };
+
+    std::vector<change> changes;
+
+    for (m_attempts = 1; ; ++m_attempts, backoff(m_attempts))
+      {
+        changes.clear();
+
+        bool busy = false;
+
+        for (auto i = m_ops.begin(); i != m_ops.end();)
+          {
+            auto *s = i->m_s;
+            auto v = s->version();
+            if (v % 2)
+              {
+                busy = true;
+                break;
+              }
+
+            // We copy the snapshot, since we change it.
+            sunits_type su = *s->units();
+
+            for (; i != m_ops.end() && i->m_s == s; ++i)
+              if (i->m_remove)
+                {
+                  if (!includes(su, i->m_cu))
+                    return false;
+                  su.remove(i->m_cu);
+                }
+              else
+                {
+                  if (!disjoint(su, i->m_cu))
+                    return false;
+                  su.insert(i->m_cu);
+                }
+
+            changes.push_back({s, v, std::make_shared<const sunits_type>
+                               (std::move(su))});
+          }
+
+        if (!busy && lock(changes))
+          break;
+      }
+
+    // We swap the snapshots, so that the old ones are released after
+    // the versions.
+    for (auto &c: changes)
+      {
+        {
+          std::lock_guard lock(c.m_s->m_mutex);
+          c.m_s->m_su.swap(c.m_su);
+        }
+        c.m_s->m_version.store(c.m_v + 2, std::memory_order_release);
+      }
+
+    m_ops.clear();
+    return true;
+  }
+
+  // The number of attempts of the last commit, for the statistics of
+  // the contention.
+  unsigned
+  attempts() const
+  {
+    return m_attempts;
+  }
+
+private:
+  // Does cu not overlap with su?
+  static bool
+  disjoint(const sunits_type &su, const cunits<T> &cu)
+  {
+    // The first interval that starts after cu.min, or at cu.min but
+    // ends before cu.max.
+    auto i = su.upper_bound(cu);
+
+    if (i != su.end() && (*i).min() < cu.max())
+      return false;
+
+    if (i != su.begin() && cu.min() < (*std::prev(i)).max())
+      return false;
+
+    return true;
+  }
+
+  // Lock the versions, or none if some version has changed.
+  template <typename V>
+  static bool
+  lock(V &changes)
+  {
+    for (auto i = changes.begin(); i != changes.end(); ++i)
+      {
+        auto v = i->m_v;
+        if (!i->m_s->m_version.compare_exchange_strong
+            (v, i->m_v + 1, std::memory_order_acquire))
+          {
+            while (i != changes.begin())
+              {
+                --i;
+                i->m_s->m_version.store(i->m_v, std::memory_order_release);
+              }
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  // Wait before the next attempt: spin first, and then yield, longer
+  // with every attempt.
+  static void
+  backoff(unsigned attempt)
+  {
+    if (attempt < 8)
+      for (unsigned i = 0; i < 1u << attempt; ++i)
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    else
+      for (unsigned i = 0; i < std::min(attempt, 64u); ++i)
+        std::this_thread::yield();
+  }
+};
+
+#endif // RESERVE_HPP
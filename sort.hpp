@@ -0,0 +1,181 @@
+#ifndef SORT_HPP
+#define SORT_HPP
+
+#include "cunits.hpp"
+#include "sunits.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Sort and deduplicate many sunits, e.g., the labels at the end of a
+// search phase.  Sorting the sunits with std::sort follows the pointer
+// to the intervals of every sunits at every comparison.  Instead, we
+// extract the keys first: the packed keys (see cunits.hpp) of the
+// first two intervals of every sunits, or 0 if there is no interval.
+// The keys order the sunits the same way as <=> does:
+//
+// * the empty sunits gets 0, which is less than any packed key,
+//
+// * if the first intervals are equal, the sunits with a single
+//   interval gets 0 as the second key, and so it's less,
+//
+// and so we sort the records of the keys, and compare the sunits only
+// when the records have equal non-zero second keys.  The equal sunits
+// are ordered by their positions in the range, so the sort is stable.
+// Then we move the sunits to their places once.
+//
+// The records can be sorted by a number of threads: every thread
+// sorts a chunk, and then the threads merge the chunks pairwise.
+
+struct sort_record
+{
+  std::uint64_t m_k0;
+  std::uint64_t m_k1;
+  std::size_t m_index;
+};
+
+// The record of sunits su at index.
+template <typename T, typename C>
+sort_record
+make_sort_record(const sunits<T, C> &su, std::size_t index)
+{
+  sort_record r{0, 0, index};
+
+  auto i = su.begin();
+  if (i != su.end())
+    {
+      r.m_k0 = packed_key(*i);
+      if (++i != su.end())
+        r.m_k1 = packed_key(*i);
+    }
+
+  return r;
+}
+
+// The records of the sunits of [first, last), sorted with the given
+// number of threads.
+template <std::random_access_iterator I>
+std::vector<sort_record>
+sort_records(I first, I last, unsigned threads)
+{
+  std::size_t n = last - first;
+  std::vector<sort_record> rs(n);
+
+  auto less = [first](const auto &a, const auto &b)
+  {
+    if (a.m_k0 != b.m_k0)
+      return a.m_k0 < b.m_k0;
+    if (a.m_k1 != b.m_k1)
+      return a.m_k1 < b.m_k1;
+    if (a.m_k1)
+      if (auto o = first[a.m_index] <=> first[b.m_index]; o != 0)
+        return o < 0;
+    return a.m_index < b.m_index;
+  };
+
+  // The chunks of the threads, of at least 1024 sunits.
+  threads = std::max(1u, std::min<unsigned>(threads, n / 1024 + 1));
+  std::vector<std::size_t> bounds;
+  for (unsigned t = 0; t <= threads; ++t)
+    bounds.push_back(n * t / threads);
+
+  auto chunk = [&](unsigned t)
+  {
+    for (auto k = bounds[t]; k < bounds[t + 1]; ++k)
+      rs[k] = make_sort_record(first[k], k);
+    std::sort(rs.begin() + bounds[t], rs.begin() + bounds[t + 1], less);
+  };
+
+  if (threads == 1)
+    chunk(0);
+  else
+    {
+      std::vector<std::thread> ts;
+      for (unsigned t = 0; t < threads; ++t)
+        ts.emplace_back(chunk, t);
+      for (auto &t: ts)
+        t.join();
+    }
+
+  // Merge the chunks pairwise: chunk t with chunk t + s, where s
+  // doubles every round.
+  for (unsigned s = 1; s < threads; s *= 2)
+    {
+      std::vector<std::thread> ts;
+      for (unsigned t = 0; t + s < threads; t += 2 * s)
+        ts.emplace_back([&, t, s]
+        {
+          auto b = rs.begin();
+          std::inplace_merge(b + bounds[t], b + bounds[t + s],
+                             b + bounds[std::min(t + 2 * s, threads)],
+                             less);
+        });
+      for (auto &t: ts)
+        t.join();
+    }
+
+  return rs;
+}
+
+// Move the sunits of [first, last) to the order of the records, and
+// skip the sunits equal to the previous one if unique.  Return the
+// new end.
+template <std::random_access_iterator I>
+I
+permute_sunits(I first, const std::vector<sort_record> &rs, bool unique)
+{
+  std::vector<std::iter_value_t<I>> tmp;
+  tmp.reserve(rs.size());
+
+  for (std::size_t k = 0; k < rs.size(); ++k)
+    {
+      const auto &r = rs[k];
+
+      if (unique && k)
+        if (const auto &p = rs[k - 1]; p.m_k0 == r.m_k0 && p.m_k1 == r.m_k1
+            && (!r.m_k1 || tmp.back() == first[r.m_index]))
+          continue;
+
+      tmp.push_back(std::move(first[r.m_index]));
+    }
+
+  return std::move(tmp.begin(), tmp.end(), first);
+}
+
+// Sort the sunits of [first, last) in the ascending order of <=>,
+// with the given number of threads.
+template <std::random_access_iterator I>
+void
+sort_sunits(I first, I last, unsigned threads = 1)
+{
+  using T = typename std::iter_value_t<I>::size_type;
+
+  if constexpr (packable<T>)
+    permute_sunits(first, sort_records(first, last, threads), false);
+  else
+    std::stable_sort(first, last);
+}
+
+// Sort the sunits of [first, last), and remove the duplicates.
+// Return the new end, as std::unique does.
+template <std::random_access_iterator I>
+I
+sort_unique_sunits(I first, I last, unsigned threads = 1)
+{
+  using T = typename std::iter_value_t<I>::size_type;
+
+  if constexpr (packable<T>)
+    return permute_sunits(first, sort_records(first, last, threads), true);
+  else
+    {
+      std::stable_sort(first, last);
+      return std::unique(first, last);
+    }
+}
+
+#endif // SORT_HPP
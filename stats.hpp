@@ -0,0 +1,144 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+// Opt-in instrumentation of sunits.  Define UNITS_STATS before
+// including any of the headers to have the operations counted.
+// Without UNITS_STATS the counting calls compile to nothing, and
+// sunits uses the plain std::allocator, so there is no cost.
+//
+// The counters are global (shared by all sunits of all types) and
+// are updated with relaxed atomics, so they can be used in
+// multi-threaded programs.  Call units_stats_snapshot() to get the
+// current values, and units_stats_reset() to zero them.
+
+#ifdef UNITS_STATS
+inline constexpr bool units_stats_enabled = true;
+#else
+inline constexpr bool units_stats_enabled = false;
+#endif
+
+template <typename N>
+struct basic_units_stats
+{
+  // The number of calls to the operations.
+  N insert, remove, includes, intersection, verify;
+
+  // The number of intervals shifted in the base container by insert
+  // and remove.
+  N moved;
+
+  // The number of allocations and the number of bytes allocated.
+  N allocations, bytes;
+
+  // The distribution of the number of intervals in a set, sampled
+  // after every insert and remove.  Bucket 0 counts empty sets, and
+  // bucket k counts sets of [2^(k - 1), 2^k) intervals.  The last
+  // bucket counts the larger sets too.
+  std::array<N, 16> intervals;
+};
+
+// The snapshot we hand out.
+using units_stats = basic_units_stats<unsigned long long>;
+
+// The counters we update.
+inline basic_units_stats<std::atomic<unsigned long long>> units_counters;
+
+inline void
+stats_count(std::atomic<unsigned long long> &c, unsigned long long n = 1)
+{
+  if constexpr (units_stats_enabled)
+    c.fetch_add(n, std::memory_order_relaxed);
+}
+
+// Sample the number of intervals in a set.
+inline void
+stats_sample(std::size_t n)
+{
+  if constexpr (units_stats_enabled)
+    {
+      auto &h = units_counters.intervals;
+      std::size_t k = std::bit_width(n);
+      stats_count(h[k < h.size() ? k : h.size() - 1]);
+    }
+}
+
+inline units_stats
+units_stats_snapshot()
+{
+  const auto &c = units_counters;
+  units_stats s;
+
+  s.insert = c.insert.load(std::memory_order_relaxed);
+  s.remove = c.remove.load(std::memory_order_relaxed);
+  s.includes = c.includes.load(std::memory_order_relaxed);
+  s.intersection = c.intersection.load(std::memory_order_relaxed);
+  s.verify = c.verify.load(std::memory_order_relaxed);
+  s.moved = c.moved.load(std::memory_order_relaxed);
+  s.allocations = c.allocations.load(std::memory_order_relaxed);
+  s.bytes = c.bytes.load(std::memory_order_relaxed);
+
+  for (std::size_t k = 0; k < s.intervals.size(); ++k)
+    s.intervals[k] = c.intervals[k].load(std::memory_order_relaxed);
+
+  return s;
+}
+
+inline void
+units_stats_reset()
+{
+  auto &c = units_counters;
+
+  for (auto *p: {&c.insert, &c.remove, &c.includes, &c.intersection,
+                 &c.verify, &c.moved, &c.allocations, &c.bytes})
+    p->store(0, std::memory_order_relaxed);
+
+  for (auto &b: c.intervals)
+    b.store(0, std::memory_order_relaxed);
+}
+
+// The allocator that counts the allocations and the bytes allocated.
+template <typename V>
+struct stats_allocator
+{
+  using value_type = V;
+
+  stats_allocator() = default;
+
+  template <typename U>
+  stats_allocator(const stats_allocator<U> &)
+  {
+  }
+
+  V *
+  allocate(std::size_t n)
+  {
+    stats_count(units_counters.allocations);
+    stats_count(units_counters.bytes, n * sizeof(V));
+    return std::allocator<V>().allocate(n);
+  }
+
+  void
+  deallocate(V *p, std::size_t n)
+  {
+    std::allocator<V>().deallocate(p, n);
+  }
+
+  constexpr bool operator == (const stats_allocator &) const = default;
+};
+
+// The allocator of the base container of sunits.
+#ifdef UNITS_STATS
+template <typename V>
+using units_allocator = stats_allocator<V>;
+#else
+template <typename V>
+using units_allocator = std::allocator<V>;
+#endif
+
+#endif // STATS_HPP
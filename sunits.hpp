@@ -2,16 +2,191 @@
 #define SUNITS_HPP
 
 #include "cunits.hpp"
+#include "stats.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <memory>
 #include <numeric>
+#include <set>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// The level of checking the invariant (the intervals are sorted and
+// neither overlap nor touch) after every insert and remove:
+//
+// * 0 - no checking,
+//
+// * 1 - local checking: only the neighbourhood of the changed
+//   intervals is checked, which takes O(1) time,
+//
+// * 2 - paranoid checking: the whole container is checked with
+//   verify(), which takes O(n) time.
+//
+// The level does not depend on NDEBUG, so that the local checking
+// can be enabled in the release builds.  By default we check locally
+// unless NDEBUG is defined.  Every translation unit should use the
+// same level.
+#ifndef UNITS_CHECK
+#ifdef NDEBUG
+#define UNITS_CHECK 0
+#else
+#define UNITS_CHECK 1
+#endif
+#endif
+
+// Report the broken invariant.  We can't use assert, because it's
+// gone with NDEBUG.
+[[noreturn]] inline void
+units_check_failed(const char *file, int line)
+{
+  std::cerr << file << ':' << line
+            << ": sunits invariant violated" << std::endl;
+  std::abort();
+}
+
+// Opt-in tracing of the operations.  Define UNITS_TRACE before
+// including any of the headers to have the calls of insert, remove,
+// includes, intersection and intersect_with (also as &=) recorded
+// with their operands, and start the recording with trace_start()
+// of trace.hpp.  We record only the outermost calls, and not, e.g.,
+// the inserts made by intersection.
+#ifdef UNITS_TRACE
+inline constexpr bool units_trace_enabled = true;
+#else
+inline constexpr bool units_trace_enabled = false;
+#endif
+
+enum class units_op: char {insert = 'i', remove = 'r', includes = 'c',
+                           includes_set = 's', intersection = 'x',
+                           intersect_with = 'w'};
+
+// The depth of the calls of the traced operations in this thread.
+inline thread_local unsigned units_trace_depth = 0;
+
+// Record the call of operation op with operands a, if it's the
+// outermost call.  The recording function is found at the
+// instantiation, and so it can come from trace.hpp.
+struct trace_scope
+{
+  template <typename... A>
+  trace_scope([[maybe_unused]] units_op op, [[maybe_unused]] const A &... a)
+  {
+    if constexpr (units_trace_enabled)
+      if (!units_trace_depth++)
+        units_trace_record(op, a...);
+  }
+
+  ~trace_scope()
+  {
+    if constexpr (units_trace_enabled)
+      --units_trace_depth;
+  }
+};
+
+// The generation of sunits for the recording: the number of its
+// changes, so that the recording writes the intervals of sunits only
+// when they have changed since the last record, and the state the
+// recording keeps of the sunits: its id in the recording session, and
+// the generation recorded last.  The copy of sunits is new to the
+// recording, and the assignment is a change.  Without UNITS_TRACE the
+// generation is empty, and it takes no space in sunits.
+#ifdef UNITS_TRACE
+struct trace_generation
+{
+  std::uint64_t m_gen = 0;
+  mutable std::uint64_t m_session = 0;
+  mutable std::uint64_t m_id = 0;
+  mutable std::uint64_t m_recorded = 0;
+
+  trace_generation() = default;
+
+  trace_generation(const trace_generation &)
+  {
+  }
+
+  trace_generation(trace_generation &&g)
+  {
+    g.bump();
+  }
+
+  trace_generation &
+  operator = (const trace_generation &)
+  {
+    bump();
+    return *this;
+  }
+
+  trace_generation &
+  operator = (trace_generation &&g)
+  {
+    bump();
+    g.bump();
+    return *this;
+  }
+
+  bool
+  operator == (const trace_generation &) const
+  {
+    return true;
+  }
+
+  void
+  bump()
+  {
+    ++m_gen;
+  }
+};
+
+// Count the changes in the scope as a single change, regardless of
+// the changes nested, so that the recording knows the generation
+// after the operation it records.
+struct trace_change
+{
+  trace_generation &m_g;
+  std::uint64_t m_gen;
+
+  trace_change(trace_generation &g): m_g(g), m_gen(g.m_gen)
+  {
+  }
+
+  ~trace_change()
+  {
+    m_g.m_gen = m_gen + 1;
+  }
+};
+#else
+struct trace_generation
+{
+  bool
+  operator == (const trace_generation &) const
+  {
+    return true;
+  }
+
+  void
+  bump()
+  {
+  }
+};
+
+struct trace_change
+{
+  trace_change(trace_generation &)
+  {
+  }
+};
+#endif
+
 // A sequence of non-overlapping intervals.  Intervals are stored in a
 // base container that we keep sorted using std::greater that uses >
 // rewritten from <=>.  Since the intervals in the container do not
@@ -67,14 +242,47 @@
 // i.e., from left to right) interval in the base container such that
 // iv > *i.  The function may return a pointer to the beginning or the
 // end.
+//
+// The base container (the store) is a policy.  It has to keep the
+// intervals in the order we insert them, offer bidirectional
+// iterators, insert(position, interval), erase(position), and
+// erase(first, last).  If it has member upper_bound(iv) with the
+// semantics of the std::upper_bound above, we use it.
+
+// The default store: intervals are shifted by insert and remove,
+// which takes O(n) time, but the search and the traversal are fast
+// and there is a single allocation.
+template <typename T>
+using vector_store = std::vector<cunits<T>, units_allocator<cunits<T>>>;
+
+// The store for large sets: the balanced tree of std::set that keeps
+// the intervals sorted with >, the same order as we keep.  Insert and
+// remove take O(log n) time.
+template <typename T>
+using tree_store = std::set<cunits<T>, std::greater<cunits<T>>,
+                            units_allocator<cunits<T>>>;
 
-template <std::totally_ordered T>
-struct sunits: private std::vector<cunits<T>>
+// Is the store a vector?  Then we can write the intervals in place.
+template <typename C>
+inline constexpr bool is_vector_store = false;
+
+template <typename V, typename A>
+inline constexpr bool is_vector_store<std::vector<V, A>> = true;
+
+template <std::totally_ordered T, typename C = vector_store<T>>
+struct sunits: private C
 {
   using data_type = cunits<T>;
-  using base_type = std::vector<data_type>;
+  using base_type = C;
   using size_type = T;
 
+  static_assert(std::same_as<typename C::value_type, data_type>);
+
+private:
+  [[no_unique_address]] trace_generation m_trace;
+
+public:
+
   sunits()
   {
   }
@@ -85,7 +293,16 @@ struct sunits: private std::vector<cunits<T>>
       insert(cu);
   }
 
-  constexpr bool operator == (const sunits &) const = default;
+  // Adopt the intervals of the store, e.g., of a non-owning store.
+  // They must be sorted, and neither overlap nor touch, which we
+  // check at the paranoid level only.
+  explicit sunits(base_type store): base_type(std::move(store))
+  {
+    if constexpr (UNITS_CHECK >= 2)
+      check(begin(), end());
+  }
+
+  bool operator == (const sunits &) const = default;
 
   // We can and we want to compare sunits lexicographically.  The
   // lexicographical ordering considers the non-empty range i greater
@@ -113,10 +330,39 @@ struct sunits: private std::vector<cunits<T>>
                            {return c + in.size();});
   }
 
+  // The store, e.g., to query it.
+  const base_type &
+  store() const
+  {
+    return *this;
+  }
+
+  // The generation for the recording of trace.hpp.
+  const trace_generation &
+  generation() const
+  {
+    return m_trace;
+  }
+
+  // Returns iterator i to the first interval such that iv > *i.
+  auto
+  upper_bound(const data_type &iv) const
+  {
+    if constexpr (requires {base_type::upper_bound(iv);})
+      return base_type::upper_bound(iv);
+    else
+      return std::upper_bound(begin(), end(), iv,
+                              std::greater<data_type>());
+  }
+
   // Insert an interval iv.  No part of it can already be included.
   void
   insert(const data_type &iv)
   {
+    stats_count(units_counters.insert);
+    trace_scope trace(units_op::insert, *this, iv);
+    trace_change change(m_trace);
+
     // Returns a position i where to insert iv.
     //
     // Returned i is such that iv > *i, and since the intervals (iv
@@ -136,8 +382,7 @@ struct sunits: private std::vector<cunits<T>>
     //
     // 0    p           iv      *i
     // |----*======o----*==o----*====o---->
-    auto i = std::upper_bound(begin(), end(), iv,
-                              std::greater<data_type>());
+    auto i = upper_bound(iv);
     auto j = i;
 
     // These are the endpoints of the interval to insert.  Look left
@@ -159,13 +404,19 @@ struct sunits: private std::vector<cunits<T>>
     if (j != end() && max == j->min())
       max = j->max(), ++j;
 
+    // The intervals after j get shifted by erase, and then the
+    // intervals after the erased ones get shifted by insert.
+    if (i != j)
+      stats_count(units_counters.moved, shifted(j));
     j = base_type::erase(i, j);
+    stats_count(units_counters.moved, shifted(j));
     data_type icu(min, max);
     auto pos = base_type::insert(j, icu);
     // Make sure the insertion was successfull.
     assert(*pos == icu);
+    stats_sample(base_type::size());
 
-    assert(verify());
+    check(pos, std::next(pos));
   }
 
   // Remove an interval iv.  The interval must be already included.
@@ -193,9 +444,12 @@ struct sunits: private std::vector<cunits<T>>
   void
   remove(const data_type &iv)
   {
+    stats_count(units_counters.remove);
+    trace_scope trace(units_op::remove, *this, iv);
+    trace_change change(m_trace);
+
     // Iterator i points to the first element for which iv > *i.
-    auto i = std::upper_bound(begin(), end(), iv,
-                              std::greater<data_type>());
+    auto i = upper_bound(iv);
 
     // There must exist an element p previous to *i such that p >= iv.
     //
@@ -213,6 +467,7 @@ struct sunits: private std::vector<cunits<T>>
     const auto cop = *i;
     assert(includes(cop, iv));
     // Remove p.
+    stats_count(units_counters.moved, shifted(std::next(i)));
     i = base_type::erase(i);
 
     // If there were some units on the right in p, we add them.  We
@@ -221,24 +476,203 @@ struct sunits: private std::vector<cunits<T>>
     // side.  We can't swap the order (i.e., first from the left, then
     // from the right) because the leftover intervals would be
     // reversed, making the base container inconsistent.
+    //
+    // We count the leftover intervals to check them later.
+    int n = 0;
     if (iv.max() < cop.max())
-      i = base_type::insert(i, data_type(iv.max(), cop.max()));
+      {
+        stats_count(units_counters.moved, shifted(i));
+        i = base_type::insert(i, data_type(iv.max(), cop.max()));
+        ++n;
+      }
     // If there were some units on the left in p, we add them.
     if (cop.min() < iv.min())
-      base_type::insert(i, data_type(cop.min(), iv.min()));
+      {
+        stats_count(units_counters.moved, shifted(i));
+        i = base_type::insert(i, data_type(cop.min(), iv.min()));
+        ++n;
+      }
+    stats_sample(base_type::size());
 
-    assert(verify());
+    check(i, std::next(i, n));
+  }
+
+  // Intersect with su in place.  For the vectors, the intervals are
+  // written over the existing ones, and so most often no allocation
+  // takes place.  With other stores we just assign the intersection.
+  void
+  intersect_with(const sunits &su)
+  {
+    trace_scope trace(units_op::intersect_with, *this, su);
+    trace_change change(m_trace);
+
+    if constexpr (is_vector)
+      intersect_in_place(su);
+    else
+      *this = intersection(std::as_const(*this), su);
+  }
+
+  // Intersect with a temporary su in place.  If su has a larger
+  // buffer, we take it, since the intersection is commutative.
+  void
+  intersect_with(sunits &&su)
+  {
+    trace_scope trace(units_op::intersect_with, *this, su);
+    trace_change change(m_trace);
+
+    if constexpr (is_vector)
+      if (base_type::capacity() < su.capacity())
+        {
+          base_type::swap(su);
+          su.m_trace.bump();
+        }
+
+    intersect_with(std::as_const(su));
+  }
+
+  // Intersect with interval iv in place.  The intervals of stores
+  // other than vectors can be immutable, and so for them we assign
+  // the intersection.
+  void
+  intersect_with(const data_type &iv)
+  {
+    trace_scope trace(units_op::intersect_with, *this, iv);
+    trace_change change(m_trace);
+
+    if constexpr (is_vector)
+      trim(iv);
+    else
+      {
+        sunits ret;
+        for (const auto &cu: *this)
+          if (cu.min() < iv.max() && iv.min() < cu.max())
+            ret.insert(data_type(std::max(cu.min(), iv.min()),
+                                 std::min(cu.max(), iv.max())));
+        *this = std::move(ret);
+      }
+  }
+
+  template <typename A>
+  sunits &
+  operator &= (A &&a)
+  {
+    intersect_with(std::forward<A>(a));
+    return *this;
   }
 
-private:
   // Make sure the intervals are in order.
   bool
-  verify()
+  verify() const
+  {
+    return verify(begin(), end());
+  }
+
+private:
+  static constexpr bool is_vector = is_vector_store<C>;
+
+  // The number of intervals shifted by inserting or erasing at i.
+  // Only vectors shift.
+  template <typename I>
+  std::size_t
+  shifted(I i) const
+  {
+    if constexpr (is_vector)
+      return end() - i;
+    else
+      return 0;
+  }
+
+  // Intersect with su in place.  We write the intersected intervals
+  // over the intervals of *this from the front, while we read the
+  // intervals of *this ahead of the writing position.  The writing
+  // position can overtake the reading position, because an interval
+  // of *this can overlap with a number of intervals of su, so we
+  // first count how much it overtakes by, and shift the intervals of
+  // *this to the right by as much.  Most often we do not have to
+  // shift at all.
+  void
+  intersect_in_place(const sunits &su)
+  {
+    stats_count(units_counters.intersection);
+
+    // The writing position, and the shift needed.
+    std::size_t w = 0, off = 0;
+
+    overlaps(0, su, [&](std::size_t r, const data_type &)
+    {
+      if (w > r)
+        off = std::max(off, w - r);
+      ++w;
+    });
+
+    if (off)
+      {
+        stats_count(units_counters.moved, base_type::size());
+        data_type x = base_type::front();
+        base_type::insert(begin(), off, x);
+      }
+
+    w = 0;
+    overlaps(off, su, [&](std::size_t, const data_type &cu)
+    {
+      base_type::operator[](w++) = cu;
+    });
+
+    base_type::erase(begin() + w, end());
+    stats_sample(base_type::size());
+
+    check(begin(), end());
+  }
+
+  // Drop the intervals outside iv, and trim the first and the last
+  // interval.
+  void
+  trim(const data_type &iv)
+  {
+    stats_count(units_counters.intersection);
+
+    // The intervals are sorted, so we can use the binary search.
+    auto i = std::partition_point(begin(), end(), [&](const auto &cu)
+                                  {return cu.max() <= iv.min();});
+    auto j = std::partition_point(i, end(), [&](const auto &cu)
+                                  {return cu.min() < iv.max();});
+
+    base_type::erase(j, end());
+    base_type::erase(begin(), i);
+
+    if (!empty())
+      {
+        auto &f = base_type::front();
+        f = data_type(std::max(f.min(), iv.min()), f.max());
+        auto &b = base_type::back();
+        b = data_type(b.min(), std::min(b.max(), iv.max()));
+      }
+
+    stats_sample(base_type::size());
+
+    check(begin(), end());
+  }
+
+
+  // Make sure the intervals in [first, last) are in order, and in
+  // order with their neighbours, i.e., the interval preceding first
+  // and the interval pointed to by last.
+  template <typename I>
+  bool
+  verify(I first, I last) const
   {
-    // Make sure the container is not empty.
-    if (auto i = begin(); i != end())
+    stats_count(units_counters.verify);
+
+    // Extend the range with the neighbours.
+    if (first != begin())
+      --first;
+    if (last != end())
+      ++last;
+
+    // Make sure the range is not empty.
+    if (auto i = first; i != last)
       // Iterate over every neighbouring pair: p is previous to i.
-      for (auto p = i; ++i != end(); ++p)
+      for (auto p = i; ++i != last; ++p)
         // Must hold: p->max() < i->min().  They cannot equal, because
         // then they should have been merged.
         if (!(p->max() < i->min()))
@@ -246,14 +680,123 @@ private:
 
     return true;
   }
+
+  // Call f(r, cu) for every overlap cu of the intervals of *this
+  // starting at position r, and the intervals of su, where r is the
+  // position of the interval of *this that cu comes from.  We keep a
+  // copy of the current interval of *this, so that f can overwrite
+  // it.
+  template <typename F>
+  void
+  overlaps(std::size_t r, const sunits &su, F f)
+  {
+    auto e = base_type::size();
+    auto j = su.begin();
+
+    if (r == e || j == su.end())
+      return;
+
+    data_type i = base_type::operator[](r);
+
+    while(true)
+      {
+        if (i.max() <= j->min())
+          {
+            if (++r == e)
+              break;
+            i = base_type::operator[](r);
+            continue;
+          }
+
+        if (j->max() <= i.min())
+          {
+            if (++j == su.end())
+              break;
+            continue;
+          }
+
+        // At this point the intervals of i and j overlap.
+        f(r, data_type(std::max(i.min(), j->min()),
+                       std::min(i.max(), j->max())));
+
+        if (i.max() < j->max())
+          {
+            if (++r == e)
+              break;
+            i = base_type::operator[](r);
+          }
+        else if (++j == su.end())
+          break;
+      }
+  }
+
+  // Check the invariant at the level of UNITS_CHECK after the
+  // intervals in [first, last) have changed.
+  template <typename I>
+  void
+  check([[maybe_unused]] I first, [[maybe_unused]] I last) const
+  {
+    if constexpr (UNITS_CHECK >= 2)
+      {
+        if (!verify())
+          units_check_failed(__FILE__, __LINE__);
+      }
+    else if constexpr (UNITS_CHECK == 1)
+      {
+        if (!verify(first, last))
+          units_check_failed(__FILE__, __LINE__);
+      }
+  }
 };
 
+// Do the stores keep the intervals contiguously in memory, as
+// vector_store does?
+template <typename... C>
+inline constexpr bool is_contiguous_store =
+  (std::contiguous_iterator<typename C::const_iterator> && ...);
+
+// The lexicographic comparison of the packed intervals kept
+// contiguously.  We skip the equal prefix with memcmp, which compares
+// a block of intervals at a time (with the vector instructions), and
+// then compare the first different intervals with their packed keys.
+template <typename T, typename C1, typename C2>
+std::strong_ordering
+compare_packed(const sunits<T, C1> &i, const sunits<T, C2> &j)
+{
+  static_assert(std::has_unique_object_representations_v<cunits<T>>);
+
+  // The number of intervals compared with a single memcmp.
+  constexpr std::size_t B = 8;
+
+  const cunits<T> *a = std::to_address(i.begin());
+  const cunits<T> *b = std::to_address(j.begin());
+  std::size_t na = std::distance(i.begin(), i.end());
+  std::size_t nb = std::distance(j.begin(), j.end());
+  std::size_t n = std::min(na, nb);
+
+  std::size_t k = 0;
+  while (k + B <= n && !std::memcmp(a + k, b + k, B * sizeof(cunits<T>)))
+    k += B;
+
+  for (; k < n; ++k)
+    if (a[k] != b[k])
+      return packed_key(a[k]) <=> packed_key(b[k]);
+
+  // The shorter is less.
+  return na <=> nb;
+}
+
 // The implementation that compares lexicographically.  Take a look
 // above at the commented out defaulted declaration of member <=> --
-// if that finally complies, we can remove the function below.
-template <typename T>
-auto operator <=> (const sunits<T> &i, const sunits<T> &j)
+// if that finally complies, we can remove the function below.  The
+// stores can differ, e.g., to compare with the views of sunits_pool.
+template <typename T, typename C1, typename C2>
+auto operator <=> (const sunits<T, C1> &i, const sunits<T, C2> &j)
 {
+  if constexpr (is_contiguous_store<C1, C2> && packable<T> &&
+                std::has_unique_object_representations_v<cunits<T>>)
+    return compare_packed(i, j);
+
   // Could be as easy as below, but ain't accepted by older compilers.
   //
   // return std::lexicographical_compare_three_way(i.begin(), i.end(),
@@ -290,9 +833,9 @@ auto operator <=> (const sunits<T> &i, const sunits<T> &j)
   return std::strong_ordering::equal;
 }
 
-template <typename T>
+template <typename T, typename C>
 std::ostream &
-operator << (std::ostream &out, const sunits<T> &su)
+operator << (std::ostream &out, const sunits<T, C> &su)
 {
   out << '{';
 
@@ -311,9 +854,9 @@ operator << (std::ostream &out, const sunits<T> &su)
   return out;
 }
 
-template <typename T>
+template <typename T, typename C>
 std::istream &
-operator >> (std::istream &in, sunits<T> &su)
+operator >> (std::istream &in, sunits<T, C> &su)
 {
   char c;
 
@@ -334,10 +877,13 @@ operator >> (std::istream &in, sunits<T> &su)
 }
 
 // Every interval of b has to be in a.
-template <typename T>
+template <typename T, typename C1, typename C2>
 bool
-includes(const sunits<T> &a, const sunits<T> &b)
+includes(const sunits<T, C1> &a, const sunits<T, C2> &b)
 {
+  stats_count(units_counters.includes);
+  trace_scope trace(units_op::includes_set, a, b);
+
   auto i = a.begin();
 
   // Every cu of a, has to be in *this.
@@ -366,10 +912,12 @@ includes(const sunits<T> &a, const sunits<T> &b)
 // Every interval of b has to be in a. That's another implementation
 // that turned out to be a bit slower (in some of my tests) than the
 // above.
-template <typename T>
+template <typename T, typename C>
 bool
-includes2(const sunits<T> &a, const sunits<T> &b)
+includes2(const sunits<T, C> &a, const sunits<T, C> &b)
 {
+  stats_count(units_counters.includes);
+
   auto j = b.begin();
 
   if (j != b.end())
@@ -397,14 +945,14 @@ includes2(const sunits<T> &a, const sunits<T> &b)
   return true;
 }
 
-template <typename T>
+template <typename T, typename C>
 bool
-includes(const sunits<T> &su, const cunits<T> &iv)
+includes(const sunits<T, C> &su, const cunits<T> &iv)
 {
-  using data_type = typename sunits<T>::data_type;
+  stats_count(units_counters.includes);
+  trace_scope trace(units_op::includes, su, iv);
 
-  auto i = std::upper_bound(su.begin(), su.end(), iv,
-                            std::greater<data_type>());
+  auto i = su.upper_bound(iv);
 
   // If there is no preceding interval, then iv is not included.  If
   // there is a preceding interval, then it's the only interval that
@@ -413,11 +961,32 @@ includes(const sunits<T> &su, const cunits<T> &iv)
   return i != su.begin() && includes(*--i, iv);
 }
 
-template <typename T>
-sunits<T>
-intersection(const sunits<T> &a, const sunits<T> &b)
+// The store that owns the intervals of the result of the operations
+// on sunits with store C.  The non-owning stores specialize it.
+template <typename C>
+struct owning_store
+{
+  using type = C;
+};
+
+template <typename C>
+using owning_store_t = typename owning_store<C>::type;
+
+// Do the sunits with store C own their intervals?  Then we can reuse
+// them.
+template <typename C>
+inline constexpr bool is_owning_store = std::same_as<C, owning_store_t<C>>;
+
+// The stores can differ, and then the result has the owning store of
+// a.
+template <typename T, typename C1, typename C2>
+sunits<T, owning_store_t<C1>>
+intersection(const sunits<T, C1> &a, const sunits<T, C2> &b)
 {
-  sunits<T> ret;
+  stats_count(units_counters.intersection);
+  trace_scope trace(units_op::intersection, a, b);
+
+  sunits<T, owning_store_t<C1>> ret;
 
   auto i = a.begin();
   auto j = b.begin();
@@ -441,17 +1010,83 @@ intersection(const sunits<T> &a, const sunits<T> &b)
       auto max = std::min(i->max(), j->max());
       ret.insert({min, max});
 
-      i->max() < j->max() ? ++i : ++j;
+      if (i->max() < j->max())
+        ++i;
+      else
+        ++j;
     }
 
   return ret;
 }
 
-template <typename T>
-sunits<T>
-intersection(const cunits<T> &a, const sunits<T> &b)
+// The intersection that reuses the buffer of a temporary.
+template <typename T, typename C>
+requires is_owning_store<C>
+sunits<T, C>
+intersection(sunits<T, C> &&a, const sunits<T, C> &b)
+{
+  trace_scope trace(units_op::intersection, a, b);
+  a.intersect_with(b);
+  return std::move(a);
+}
+
+template <typename T, typename C>
+requires is_owning_store<C>
+sunits<T, C>
+intersection(const sunits<T, C> &a, sunits<T, C> &&b)
+{
+  trace_scope trace(units_op::intersection, a, b);
+  b.intersect_with(a);
+  return std::move(b);
+}
+
+template <typename T, typename C>
+requires is_owning_store<C>
+sunits<T, C>
+intersection(sunits<T, C> &&a, sunits<T, C> &&b)
+{
+  trace_scope trace(units_op::intersection, a, b);
+  a.intersect_with(std::move(b));
+  return std::move(a);
+}
+
+template <typename T, typename C>
+sunits<T, owning_store_t<C>>
+intersection(const cunits<T> &a, const sunits<T, C> &b)
+{
+  trace_scope trace(units_op::intersection, a, b);
+
+  if constexpr (is_owning_store<C>)
+    {
+      sunits<T, C> ret = b;
+      ret.intersect_with(a);
+      return ret;
+    }
+  else
+    {
+      stats_count(units_counters.intersection);
+
+      sunits<T, owning_store_t<C>> ret;
+      for (const auto &cu: b)
+        if (auto min = std::max(cu.min(), a.min()),
+            max = std::min(cu.max(), a.max()); min < max)
+          ret.insert({min, max});
+      return ret;
+    }
+}
+
+template <typename T, typename C>
+requires is_owning_store<C>
+sunits<T, C>
+intersection(const cunits<T> &a, sunits<T, C> &&b)
 {
-  return intersection(sunits<T>{a}, b);
+  trace_scope trace(units_op::intersection, a, b);
+  b.intersect_with(a);
+  return std::move(b);
 }
 
+#ifdef UNITS_TRACE
+#include "trace.hpp"
+#endif
+
 #endif // SUNITS_HPP
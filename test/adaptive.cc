@@ -0,0 +1,215 @@
+#include "adaptive.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <climits>
+#include <iterator>
+#include <random>
+
+using ASU = sunits<unsigned, adaptive_store<unsigned>>;
+
+// Make sure a and r have the same intervals.
+bool
+same(const ASU &a, const SU &r)
+{
+  return std::equal(a.begin(), a.end(), r.begin(), r.end());
+}
+
+void
+test_migration()
+{
+  ASU s;
+  SU r;
+
+  // Few intervals: the vector.
+  s.insert({0, 1000});
+  r.insert({0, 1000});
+  assert(!s.store().in_bitmap());
+
+  // Fragment the set: the bitmap.
+  for (unsigned i = 1; i < 1000; i += 2)
+    {
+      s.remove({i, i + 1});
+      r.remove({i, i + 1});
+    }
+  assert(s.store().in_bitmap());
+  assert(same(s, r));
+  assert(s.verify());
+
+  // Defragment the set by half: still the bitmap, because of the
+  // hysteresis.
+  for (unsigned i = 1; i < 500; i += 2)
+    {
+      s.insert({i, i + 1});
+      r.insert({i, i + 1});
+    }
+  assert(s.store().in_bitmap());
+  assert(same(s, r));
+
+  // Defragment the set: the vector.
+  for (unsigned i = 501; i < 1000; i += 2)
+    {
+      s.insert({i, i + 1});
+      r.insert({i, i + 1});
+    }
+  assert(!s.store().in_bitmap());
+  assert(same(s, r));
+  assert(s.store().size() == 1);
+}
+
+void
+test_operations()
+{
+  SU a{{0, 10}, {20, 30}, {40, 50}};
+  ASU s;
+  for (unsigned i = 0; i < 200; i += 2)
+    s.insert({i, i + 1});
+  assert(s.store().in_bitmap());
+
+  assert(includes(s, {100, 101}));
+  assert(!includes(s, {101, 102}));
+  assert(!includes(s, {100, 102}));
+  assert(includes(s, ASU{{0, 1}, {198, 199}}));
+  assert(s.size() == 100);
+
+  auto t = intersection(s, ASU{{5, 10}});
+  assert(t == ASU({{6, 7}, {8, 9}}));
+  assert(ASU({{0, 1}, {2, 3}}) < s);
+  assert(s > ASU({{0, 1}}));
+}
+
+// The sets that span the whole range of the endpoints.
+void
+test_wide()
+{
+  sunits<int, adaptive_store<int>> s{{INT_MIN, INT_MIN + 1},
+                                     {INT_MAX - 1, INT_MAX}};
+  assert(!s.store().in_bitmap());
+  assert(includes(s, {INT_MIN, INT_MIN + 1}));
+  assert(includes(s, {INT_MAX - 1, INT_MAX}));
+  assert(s.verify());
+
+  sunits<unsigned long, adaptive_store<unsigned long>> l{{0, ULONG_MAX}};
+  assert(!l.store().in_bitmap());
+  l.remove({1, ULONG_MAX - 1});
+  assert(l.size() == 2);
+  assert(!l.store().in_bitmap());
+
+  // The fragmented set at the top of the range is in the bitmap.
+  sunits<int, adaptive_store<int>> t;
+  for (int i = INT_MAX - 400; i < INT_MAX - 2; i += 2)
+    t.insert({i, i + 1});
+  t.insert({INT_MAX - 1, INT_MAX});
+  assert(t.store().in_bitmap());
+  assert(includes(t, {INT_MAX - 1, INT_MAX}));
+  assert(*std::prev(t.end()) == cunits<int>(INT_MAX - 1, INT_MAX));
+  assert(t.verify());
+}
+
+// An interval far from the fragmented set.
+void
+test_far()
+{
+  ASU s;
+  SU r;
+  for (unsigned i = 0; i < 400; i += 2)
+    {
+      s.insert({i, i + 1});
+      r.insert({i, i + 1});
+    }
+  assert(s.store().in_bitmap());
+
+  // The bitmap would take about 500 MB: the vector instead.
+  s.insert({4000000000, 4000000001});
+  r.insert({4000000000, 4000000001});
+  assert(!s.store().in_bitmap());
+  assert(same(s, r));
+
+  // Without the far interval, the bitmap again.
+  s.remove({4000000000, 4000000001});
+  r.remove({4000000000, 4000000001});
+  assert(s.store().in_bitmap());
+  assert(same(s, r));
+
+  assert(s.verify());
+}
+
+// The bitmap shrinks when the intervals at its ends are erased.
+void
+test_shrink()
+{
+  ASU s;
+  SU r;
+  for (unsigned i = 0; i < 100; i += 2)
+    {
+      s.insert({i, i + 1});
+      r.insert({i, i + 1});
+    }
+
+  // The bitmap grows to 47 words, and stays with 50 intervals.
+  s.insert({3000, 3001});
+  r.insert({3000, 3001});
+  assert(s.store().in_bitmap());
+  s.remove({3000, 3001});
+  r.remove({3000, 3001});
+  assert(s.store().in_bitmap());
+
+  // With 20 intervals, the vector would take less than half of the 47
+  // words, but the bitmap has shrunk to 2 words.
+  for (unsigned i = 0; i < 60; i += 2)
+    {
+      s.remove({i, i + 1});
+      r.remove({i, i + 1});
+    }
+  assert(s.store().in_bitmap());
+  assert(same(s, r));
+  assert(s.verify());
+}
+
+// Compare with the vector store.
+void
+test_random()
+{
+  std::mt19937 g(1);
+
+  for (int n = 0; n < 100; ++n)
+    {
+      ASU s;
+      SU r;
+      unsigned u = 1 + g() % 1000;
+
+      for (int k = 0; k < 2000; ++k)
+        {
+          unsigned x = g() % u;
+          unsigned y = x + 1 + g() % std::min<unsigned>(u - x, 1 + g() % 20);
+          CU cu(x, y);
+
+          if (includes(r, cu))
+            {
+              assert(includes(s, cu));
+              s.remove(cu);
+              r.remove(cu);
+            }
+          else if (intersection(cu, r).empty())
+            {
+              assert(!includes(s, cu));
+              s.insert(cu);
+              r.insert(cu);
+            }
+        }
+
+      assert(same(s, r));
+      assert(s.verify());
+    }
+}
+
+int
+main()
+{
+  test_migration();
+  test_operations();
+  test_wide();
+  test_far();
+  test_shrink();
+  test_random();
+}
@@ -0,0 +1,109 @@
+#include "calendar.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+using CAL = calendar<unsigned, unsigned>;
+using W = cunits<unsigned>;
+
+void
+test_book()
+{
+  CAL c(W(0, 100), SU{{0, 10}});
+  assert(c.timeline().size() == 1);
+
+  assert(c.book(W(10, 20), {0, 4}));
+  assert(c.timeline().size() == 3);
+  assert(c.free(W(0, 100)) == SU({{4, 10}}));
+  assert(c.free(W(0, 10)) == SU({{0, 10}}));
+  assert(c.free(W(15, 16)) == SU({{4, 10}}));
+  assert(c.free(W(20, 100)) == SU({{0, 10}}));
+
+  // Overlaps with the booking.
+  assert(!c.fits(W(5, 15), {3, 5}));
+  assert(!c.book(W(5, 15), {3, 5}));
+  assert(c.book(W(5, 15), {4, 6}));
+  assert(c.free(W(10, 15)) == SU({{6, 10}}));
+  assert(c.free(W(5, 10)) == SU({{0, 4}, {6, 10}}));
+
+  // The equal neighbours get merged.
+  c.release(W(5, 15), {4, 6});
+  assert(c.timeline().size() == 3);
+  c.release(W(10, 20), {0, 4});
+  assert(c.timeline().size() == 1);
+  assert(c.free(W(0, 100)) == SU({{0, 10}}));
+
+  // Book until the end of the horizon.
+  assert(c.book(W(50, 100), {0, 10}));
+  assert(c.free(W(0, 100)).empty());
+  assert(c.free(W(0, 50)) == SU({{0, 10}}));
+  c.release(W(50, 100), {0, 10});
+  assert(c.timeline().size() == 1);
+}
+
+// Compare with the sunits of every time step.
+void
+test_random()
+{
+  constexpr unsigned H = 50, U = 20;
+
+  std::srand(1);
+  CAL c(W(0, H), SU{{0, U}});
+  std::vector<SU> steps(H, SU{{0, U}});
+
+  struct booking
+  {
+    W w;
+    CU cu;
+  };
+  std::vector<booking> bs;
+
+  for (int k = 0; k < 2000; ++k)
+    {
+      unsigned t = std::rand() % H, a = std::rand() % U;
+      W w(t, t + 1 + std::rand() % (H - t));
+      CU cu(a, a + 1 + std::rand() % (U - a));
+
+      bool fits = true;
+      for (auto s = w.min(); s < w.max(); ++s)
+        fits &= includes(steps[s], cu);
+
+      if (std::rand() % 3 && !bs.empty())
+        {
+          auto i = bs.begin() + std::rand() % bs.size();
+          c.release(i->w, i->cu);
+          for (auto s = i->w.min(); s < i->w.max(); ++s)
+            steps[s].insert(i->cu);
+          bs.erase(i);
+        }
+      else
+        {
+          assert(c.book(w, cu) == fits);
+          if (fits)
+            {
+              for (auto s = w.min(); s < w.max(); ++s)
+                steps[s].remove(cu);
+              bs.push_back({w, cu});
+            }
+        }
+
+      SU f = steps[w.min()];
+      for (auto s = w.min() + 1; s < w.max(); ++s)
+        f = intersection(f, steps[s]);
+      assert(c.free(w) == f);
+
+      // No equal neighbours.
+      for (auto i = c.timeline().begin();
+           std::next(i) != c.timeline().end(); ++i)
+        assert(i->second != std::next(i)->second);
+    }
+}
+
+int
+main()
+{
+  test_book();
+  test_random();
+}
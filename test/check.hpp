@@ -0,0 +1,95 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+// The tests of the checking of the invariant at level UNITS_CHECK,
+// shared by check0.cc, check1.cc and check2.cc, which define the level
+// and run the tests.  We build the sets that break the
+// invariant with the constructor that adopts a store, and run the
+// operations in a child process, which aborts when the check fails.
+
+#include "units.hpp"
+
+#include <cassert>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Does f abort?
+template <typename F>
+bool
+aborts(F f)
+{
+  pid_t pid = fork();
+  assert(pid >= 0);
+
+  if (!pid)
+    {
+      // Silence the report of the check.
+      dup2(open("/dev/null", O_WRONLY), 2);
+      f();
+      _exit(0);
+    }
+
+  int status;
+  waitpid(pid, &status, 0);
+  return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+// The set with the touching intervals [10, 20) and [20, 30), which
+// should have been merged, followed by the proper intervals.
+SU
+broken()
+{
+  return SU(vector_store<unsigned>{{10, 20}, {20, 30}, {40, 50},
+                                   {100, 110}, {200, 210}});
+}
+
+// The operations on the proper sets pass at every level.
+void
+test_proper()
+{
+  assert(!aborts([]
+  {
+    SU s{{10, 30}, {40, 50}, {200, 210}};
+    // Both leftovers.
+    s.remove({42, 45});
+    s.remove({12, 15});
+    // No leftover.
+    s.remove({200, 210});
+    s.insert({30, 40});
+    assert(s == SU({{10, 12}, {15, 42}, {45, 50}}));
+  }));
+}
+
+// The operations that change the neighbours of the broken intervals:
+// the remove of [22, 25) leaves [20, 22) and [25, 30), and the insert
+// of [30, 35) merges into [20, 35), and then the local check looks at
+// the preceding [10, 20) too.
+void
+test_near()
+{
+  bool a = aborts([]{broken().remove({22, 25});});
+  assert(a == (UNITS_CHECK >= 1));
+
+  a = aborts([]{broken().insert({30, 35});});
+  assert(a == (UNITS_CHECK >= 1));
+}
+
+// The operations far from the broken intervals: only the paranoid
+// level finds them (with the constructor already).
+void
+test_far()
+{
+  bool a = aborts([]{broken().remove({202, 205});});
+  assert(a == (UNITS_CHECK >= 2));
+
+  a = aborts([]{broken().insert({150, 160});});
+  assert(a == (UNITS_CHECK >= 2));
+
+  a = aborts([]{broken();});
+  assert(a == (UNITS_CHECK >= 2));
+}
+
+#endif // CHECK_HPP
@@ -0,0 +1,12 @@
+// Check the invariant at level 1.
+#define UNITS_CHECK 1
+
+#include "check.hpp"
+
+int
+main()
+{
+  test_proper();
+  test_near();
+  test_far();
+}
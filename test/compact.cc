@@ -0,0 +1,127 @@
+#include "compact.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+using CSU = sunits<unsigned, compact_store<unsigned>>;
+
+void
+test_widen()
+{
+  CSU s{{100, 110}};
+  assert(s.store().width() == 1);
+
+  // Still within 256 units from the base.
+  s.insert({300, 355});
+  assert(s.store().width() == 1);
+
+  // The range grows beyond 255.
+  s.insert({356, 400});
+  assert(s.store().width() == 2);
+
+  // The base moves down.
+  s.insert({0, 1});
+  assert(s.store().width() == 2);
+  assert(s == CSU({{0, 1}, {100, 110}, {300, 355}, {356, 400}}));
+
+  s.insert({1000000, 1000001});
+  assert(s.store().width() == 4);
+  assert(includes(s, {1000000, 1000001}));
+  assert(includes(s, {300, 355}));
+
+  // An empty set forgets its base and width.
+  for (const auto &cu: CSU(s))
+    s.remove(cu);
+  assert(s.empty());
+  s.insert({5, 6});
+  assert(s.store().width() == 1);
+}
+
+void
+test_narrow()
+{
+  // The base and the width are kept in the data.
+  static_assert(sizeof(CSU) == sizeof(SU));
+
+  CSU s{{100, 110}, {200, 210}, {400, 410}};
+  assert(s.store().width() == 2);
+
+  // The highest interval is erased.
+  s.remove({400, 410});
+  assert(s.store().width() == 1);
+
+  s.insert({100000, 100001});
+  assert(s.store().width() == 4);
+
+  // An interval in the middle: the range stays.
+  s.remove({200, 210});
+  assert(s.store().width() == 4);
+
+  // The lowest interval is erased, and so the base moves up.
+  s.remove({100, 110});
+  assert(s.store().width() == 1);
+  assert(s == CSU({{100000, 100001}}));
+
+  s.insert({99900, 99910});
+  s.remove({100000, 100001});
+  assert(s == CSU({{99900, 99910}}));
+  assert(s.store().width() == 1);
+}
+
+void
+test_operations()
+{
+  CSU s;
+  SU r;
+
+  for (unsigned i = 0; i < 1000; i += 3)
+    {
+      s.insert({i, i + 2});
+      r.insert({i, i + 2});
+    }
+  for (unsigned i = 2; i < 900; i += 6)
+    {
+      s.insert({i, i + 1});
+      r.insert({i, i + 1});
+    }
+  for (unsigned i = 50; i < 700; i += 13)
+    if (includes(r, {i, i + 1}))
+      {
+        s.remove({i, i + 1});
+        r.remove({i, i + 1});
+      }
+
+  assert(s.verify());
+  assert(std::equal(s.begin(), s.end(), r.begin(), r.end()));
+  assert(s.size() == r.size());
+
+  CSU a{{0, 10}, {20, 30}, {40, 50}};
+  assert(intersection(a, CSU{{5, 45}})
+         == CSU({{5, 10}, {20, 30}, {40, 45}}));
+  a &= CU(8, 25);
+  assert(a == CSU({{8, 10}, {20, 25}}));
+  assert(CSU({{0, 3}, {5, 6}}) > CSU({{0, 3}}));
+}
+
+void
+test_signed()
+{
+  sunits<std::int64_t, compact_store<std::int64_t>> s{{-5, 5}};
+  s.insert({-100, -50});
+  assert(s.store().width() == 1);
+  s.insert({1ll << 40, (1ll << 40) + 1});
+  assert(s.store().width() == 8);
+  assert(includes(s, {-100, -50}));
+  assert(includes(s, {-5, 5}));
+  assert(includes(s, {1ll << 40, (1ll << 40) + 1}));
+}
+
+int
+main()
+{
+  test_widen();
+  test_narrow();
+  test_operations();
+  test_signed();
+}
@@ -3,7 +3,9 @@
 #include "units.hpp"
 
 #include <cassert>
+#include <climits>
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -137,9 +139,55 @@ test_transitivity()
       }
 }
 
+// *****************************************************************
+// Test the packed keys.
+// *****************************************************************
+
+// The order defined by the endpoints.
+template <typename T>
+std::strong_ordering
+reference(const cunits<T> &i, const cunits<T> &j)
+{
+  if (i.min() != j.min())
+    return j.min() <=> i.min();
+  return i.max() <=> j.max();
+}
+
+// All intervals with the endpoints from v.
+template <typename T>
+void
+test_packed_key(const vector<T> &v)
+{
+  vector<cunits<T>> l;
+  for (auto a: v)
+    for (auto b: v)
+      if (a < b)
+        l.emplace_back(a, b);
+
+  for (const auto &i: l)
+    {
+      assert(packed_key(i));
+      for (const auto &j: l)
+        {
+          assert((i <=> j) == reference(i, j));
+          assert((packed_key(i) < packed_key(j)) == (i < j));
+        }
+    }
+}
+
+void
+test_packed_key()
+{
+  test_packed_key<unsigned>({0, 1, 2, 1000, UINT_MAX - 1, UINT_MAX});
+  test_packed_key<int>({INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX});
+  test_packed_key<unsigned char>({0, 1, 127, 128, 255});
+  test_packed_key<short>({SHRT_MIN, -1, 0, 1, SHRT_MAX});
+}
+
 int
 main()
 {
   test_relations();
   test_transitivity();
+  test_packed_key();
 }
@@ -0,0 +1,165 @@
+#include "delta.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <sstream>
+
+void
+test_varint()
+{
+  std::stringstream s;
+  for (std::uint64_t v: {0ull, 1ull, 127ull, 128ull, 300ull, ~0ull})
+    write_varint(s, v);
+
+  // Small numbers take a byte.
+  assert(s.str().size() == 1 + 1 + 1 + 2 + 2 + 10);
+
+  for (std::uint64_t v: {0ull, 1ull, 127ull, 128ull, 300ull, ~0ull})
+    {
+      std::uint64_t r;
+      assert(read_varint(s, r) && r == v);
+    }
+
+  std::uint64_t r;
+  assert(!read_varint(s, r));
+
+  // The 10th byte with more than the highest bit.
+  std::stringstream t(std::string(9, '\xff') + '\x02');
+  assert(!read_varint(t, r));
+}
+
+void
+test_replication()
+{
+  logged_sunits<unsigned> p;
+  p.insert({10, 20});
+  p.insert({30, 40});
+  assert(p.seq() == 2);
+
+  // The replica starts from the checkpoint.
+  std::stringstream s;
+  write_checkpoint(s, p);
+
+  SU su;
+  std::uint64_t seq;
+  assert(read_checkpoint(s, su, seq));
+  assert(su == p.units() && seq == 2);
+  logged_sunits<unsigned> r(su, seq);
+
+  // The primary changes.
+  p.insert({20, 30});
+  p.remove({0 + 15, 25});
+  p.insert({100, 1000});
+  assert(p.units() == SU({{10, 15}, {25, 40}, {100, 1000}}));
+
+  // The replica gets the deltas only.
+  s.str("");
+  s.clear();
+  write_deltas(s, p, r.seq());
+  // Every delta takes 5 or 6 bytes.
+  assert(s.str().size() <= 3 * 6);
+
+  for (delta<unsigned> d{0, delta_op::insert, {0, 1}}; read_delta(s, d);)
+    r.apply(d);
+
+  assert(r.units() == p.units());
+  assert(r.seq() == p.seq());
+
+  // The replica has applied the deltas.
+  p.truncate(r.seq());
+  assert(p.deltas(p.seq()).empty());
+}
+
+void
+test_signed()
+{
+  sunits<int> su{{-100, -50}, {-1, 1}, {1000, 1001}};
+  std::stringstream s;
+  write_checkpoint(s, su, 7);
+
+  sunits<int> r{{0, 1}};
+  std::uint64_t seq;
+  assert(read_checkpoint(s, r, seq));
+  assert(r == su && seq == 7);
+
+  delta<int> d{8, delta_op::remove, {-100, -99}};
+  write_delta(s, d);
+  delta<int> e{0, delta_op::insert, {0, 1}};
+  assert(read_delta(s, e) && e == d);
+  apply_delta(r, e);
+  assert(r == sunits<int>({{-99, -50}, {-1, 1}, {1000, 1001}}));
+}
+
+void
+test_malformed()
+{
+  std::stringstream s("D\x01x");
+  delta<unsigned> d{0, delta_op::insert, {0, 1}};
+  assert(!read_delta(s, d));
+
+  std::stringstream t("C\x01\x02\x05");
+  SU su;
+  std::uint64_t seq;
+  assert(!read_checkpoint(t, su, seq));
+}
+
+// The intervals that overflow the endpoints, or are out of order.
+void
+test_overflow()
+{
+  SU su;
+  std::uint64_t seq;
+  delta<unsigned> d{0, delta_op::insert, {0, 1}};
+
+  // The gap wraps: [10, 15), and then the min of 15 + 4294967280.
+  std::stringstream s;
+  s.put('C');
+  write_varint(s, 1);
+  write_varint(s, 2);
+  write_varint(s, 10);
+  write_varint(s, 5);
+  write_varint(s, 4294967280);
+  write_varint(s, 3);
+  assert(!read_checkpoint(s, su, seq));
+
+  // The size overflows.
+  std::stringstream t;
+  t.put('D');
+  write_varint(t, 1);
+  t.put('i');
+  write_varint(t, 4294967290);
+  write_varint(t, 10);
+  assert(!read_delta(t, d));
+
+  // The min doesn't fit.
+  std::stringstream u;
+  u.put('D');
+  write_varint(u, 1);
+  u.put('i');
+  write_varint(u, std::uint64_t(1) << 33);
+  write_varint(u, 1);
+  assert(!read_delta(u, d));
+
+  // But the intervals at the ends of the range do.
+  sunits<int> a({{INT_MIN, INT_MIN + 1}, {INT_MAX - 1, INT_MAX}}), b;
+  std::stringstream v;
+  write_checkpoint(v, a, 3);
+  assert(read_checkpoint(v, b, seq) && b == a && seq == 3);
+
+  delta<unsigned> e{4, delta_op::remove, {0, UINT_MAX}};
+  std::stringstream w;
+  write_delta(w, e);
+  assert(read_delta(w, d) && d == e);
+}
+
+int
+main()
+{
+  test_varint();
+  test_replication();
+  test_signed();
+  test_malformed();
+  test_overflow();
+}
@@ -0,0 +1,140 @@
+#include "label_queue.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using LQ = label_queue<SU>;
+
+void
+test_order()
+{
+  LQ q;
+  q.push(2, SU{{0, 5}});
+  q.push(1, SU{{0, 2}});
+  q.push(1, SU{{0, 3}});
+  q.push(1, SU{{0, 3}});
+  q.push(1, SU{{1, 3}});
+  auto h = q.push(3, SU{{0, 1}});
+  assert(q.size() == 6);
+
+  // The same cost: the better sunits first.
+  assert(q.cost(q.top()) == 1 && q.label(q.top()) == SU({{0, 3}}));
+  // The same cost and sunits: in the order pushed.
+  auto t = q.top();
+  assert(q.pop() == std::pair(1u, SU{{0, 3}}));
+  assert(q.top() != t);
+  assert(q.pop() == std::pair(1u, SU{{0, 3}}));
+  assert(q.pop() == std::pair(1u, SU{{0, 2}}));
+  assert(q.pop() == std::pair(1u, SU{{1, 3}}));
+
+  // Decrease the cost of the last one.
+  q.decrease(h, 2);
+  assert(q.pop() == std::pair(2u, SU{{0, 5}}));
+  assert(q.pop() == std::pair(2u, SU{{0, 1}}));
+  assert(q.empty());
+}
+
+void
+test_erase()
+{
+  LQ q;
+  auto a = q.push(5, SU{{0, 1}});
+  auto b = q.push(5, SU{{0, 2}});
+  q.push(7, SU{{0, 3}});
+  q.erase(b);
+  assert(q.size() == 2);
+  assert(q.top() == a);
+  q.erase(a);
+  assert(q.pop() == std::pair(7u, SU{{0, 3}}));
+  assert(q.empty());
+
+  // The slots get reused.
+  q.push(8, SU{{1, 2}});
+  assert(q.pop() == std::pair(8u, SU{{1, 2}}));
+}
+
+// Compare with the map ordered by (cost, the reversed sunits, the
+// order of pushes).
+void
+test_random()
+{
+  using key = std::tuple<unsigned, SU, unsigned>;
+  auto order = [](const key &a, const key &b)
+  {
+    if (std::get<0>(a) != std::get<0>(b))
+      return std::get<0>(a) < std::get<0>(b);
+    if (std::get<1>(a) != std::get<1>(b))
+      return std::get<1>(a) > std::get<1>(b);
+    return std::get<2>(a) < std::get<2>(b);
+  };
+
+  std::srand(1);
+  LQ q;
+  std::map<key, LQ::handle, decltype(order)> m(order);
+  // The handles of the labels.
+  std::map<LQ::handle, key> h2k;
+  unsigned last = 0, n = 0;
+
+  for (int i = 0; i < 20000; ++i)
+    {
+      int r = std::rand() % 10;
+      if (r < 5 || m.empty())
+        {
+          unsigned c = last + std::rand() % 1000;
+          unsigned a = std::rand() % 4;
+          SU su{{a, a + 1 + std::rand() % 3}};
+          auto h = q.push(c, su);
+          key k(c, su, n++);
+          m[k] = h;
+          h2k[h] = k;
+        }
+      else if (r < 7)
+        {
+          auto i = std::next(h2k.begin(), std::rand() % h2k.size());
+          auto [h, k] = *i;
+          unsigned c = std::get<0>(k);
+          unsigned d = last + (c - last) / 2;
+          q.decrease(h, d);
+          if (d < c)
+            {
+              m.erase(k);
+              std::get<0>(k) = d;
+              std::get<2>(k) = n++;
+              m[k] = h;
+              i->second = k;
+            }
+        }
+      else if (r < 8)
+        {
+          auto i = std::next(h2k.begin(), std::rand() % h2k.size());
+          q.erase(i->first);
+          m.erase(i->second);
+          h2k.erase(i);
+        }
+      else
+        {
+          auto [k, h] = *m.begin();
+          assert(q.top() == h);
+          auto p = q.pop();
+          assert(p.first == std::get<0>(k) && p.second == std::get<1>(k));
+          last = p.first;
+          m.erase(m.begin());
+          h2k.erase(h);
+        }
+
+      assert(q.size() == m.size());
+    }
+}
+
+int
+main()
+{
+  test_order();
+  test_erase();
+  test_random();
+}
@@ -0,0 +1,104 @@
+#include "compact.hpp"
+#include "metrics.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <cmath>
+
+using MSU = sunits<unsigned, metrics_store<vector_store<unsigned>>>;
+
+// Compute the metrics from scratch.
+template <typename S>
+void
+check(const S &su)
+{
+  const auto &m = su.store();
+
+  unsigned units = 0, largest = 0;
+  std::map<unsigned, std::size_t> h;
+  for (const auto &cu: su)
+    {
+      units += cu.size();
+      largest = std::max(largest, cu.size());
+      ++h[cu.size()];
+    }
+
+  double e = 0;
+  for (const auto &cu: su)
+    {
+      double p = double(cu.size()) / units;
+      e -= p * std::log(p);
+    }
+
+  assert(m.blocks() == std::size_t(std::distance(su.begin(), su.end())));
+  assert(m.units() == units);
+  assert(m.largest() == largest);
+  assert(m.histogram() == h);
+  assert(std::abs(m.entropy() - e) < 1e-9);
+}
+
+void
+test_merging()
+{
+  MSU s;
+  check(s);
+  assert(s.store().fragmentation() == 0);
+
+  s.insert({0, 10});
+  s.insert({20, 25});
+  check(s);
+  assert(s.store().largest() == 10);
+
+  // Merge the three intervals into one.
+  s.insert({10, 20});
+  check(s);
+  assert(s.store().blocks() == 1);
+  assert(s.store().entropy() == 0);
+  assert(s.store().fragmentation() == 0);
+
+  // Split the interval into two.
+  s.remove({5, 6});
+  check(s);
+  assert(s.store().largest() == 19);
+  assert(s.store().histogram().size() == 2);
+
+  s.remove({0, 5});
+  s.remove({6, 25});
+  check(s);
+  assert(s.empty());
+}
+
+void
+test_operations()
+{
+  MSU s;
+
+  for (unsigned i = 0; i < 1000; i += 7)
+    s.insert({i, i + 1 + i % 5});
+  check(s);
+
+  for (unsigned i = 0; i < 1000; i += 7)
+    if (includes(s, {i + 1, i + 2}))
+      s.remove({i + 1, i + 2});
+  check(s);
+
+  MSU t = s;
+  t &= MSU{{100, 500}};
+  check(t);
+  t &= CU(200, 300);
+  check(t);
+
+  // Other stores can be wrapped too.
+  sunits<unsigned, metrics_store<compact_store<unsigned>>> c{{0, 5}};
+  c.insert({5, 7});
+  c.insert({9, 10});
+  check(c);
+  assert(c.store().largest() == 7);
+}
+
+int
+main()
+{
+  test_merging();
+  test_operations();
+}
@@ -0,0 +1,97 @@
+#include "munits.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <vector>
+
+using MU = munits<unsigned>;
+
+void
+test_blocks()
+{
+  MU m(7, 100);
+  assert(m.all() == 0b1111111);
+  assert(!includes(m, 0b1, {0, 1}));
+
+  m.insert(0b0000110, {10, 20});
+  assert(includes(m, 0b0000110, {10, 20}));
+  assert(includes(m, 0b0000010, {15, 16}));
+  assert(!includes(m, 0b0000111, {10, 20}));
+  assert(!includes(m, 0b0000110, {9, 20}));
+  // Outside of the slots.
+  assert(!includes(m, 0b0000110, {10, 1000}));
+
+  assert(m.core(1) == SU({{10, 20}}));
+  assert(m.core(0).empty());
+
+  m.remove(0b0000100, {12, 14});
+  assert(m.core(2) == SU({{10, 12}, {14, 20}}));
+  assert(m.common(0b0000110) == SU({{10, 12}, {14, 20}}));
+}
+
+void
+test_per_core()
+{
+  std::vector<SU> v{{{0, 50}}, {{10, 60}}, {{20, 30}, {40, 100}}};
+  MU m(v, 100);
+
+  for (unsigned c = 0; c < v.size(); ++c)
+    assert(m.core(c) == v[c]);
+
+  assert(m.common(0b011) == SU({{10, 50}}));
+  assert(m.common(0b111) == SU({{20, 30}, {40, 50}}));
+}
+
+void
+test_fit()
+{
+  std::vector<SU> v{{{0, 50}}, {{10, 60}}, {{20, 30}, {40, 100}}};
+  MU m(v, 100);
+
+  // A single core: the first slots.
+  assert(m.fit(1, 10) == std::pair(MU::mask(0), CU(0, 10)));
+
+  // Two cores.
+  assert(m.fit(2, 10) == std::pair(MU::mask_type(0b011), CU(10, 20)));
+  assert(m.fit(2, 40) == std::pair(MU::mask_type(0b011), CU(10, 50)));
+  assert(m.fit(2, 20) == std::pair(MU::mask_type(0b011), CU(10, 30)));
+
+  // All three cores.
+  assert(m.fit(3, 10) == std::pair(MU::mask_type(0b111), CU(20, 30)));
+  assert(!m.fit(3, 11));
+
+  // Too many slots.
+  assert(!m.fit(1, 101));
+  assert(m.fit(1, 60) == std::pair(MU::mask(2), CU(40, 100)));
+
+  // Compare with the per-core sets for every n.
+  for (unsigned k = 1; k <= 3; ++k)
+    for (unsigned n = 1; n <= 100; ++n)
+      {
+        std::optional<CU> best;
+        for (unsigned s = 0; s + n <= 100 && !best; ++s)
+          {
+            unsigned c = 0;
+            for (const auto &su: v)
+              c += includes(su, CU(s, s + n));
+            if (c >= k)
+              best = CU(s, s + n);
+          }
+
+        auto f = m.fit(k, n);
+        assert(bool(f) == bool(best));
+        if (f)
+          {
+            assert(f->second == *best);
+            assert(includes(m, f->first, f->second));
+          }
+      }
+}
+
+int
+main()
+{
+  test_blocks();
+  test_per_core();
+  test_fit();
+}
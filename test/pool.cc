@@ -0,0 +1,90 @@
+#include "pool.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+using POOL = sunits_pool<unsigned>;
+
+void
+test_views()
+{
+  POOL p;
+  assert(p.empty());
+
+  std::vector<SU> v = {SU{{0, 3}, {5, 8}}, SU{}, SU{{1, 2}},
+                       SU{{0, 3}, {5, 8}}, SU{{2, 10}}};
+  for (const auto &su: v)
+    p.append(su);
+  assert(p.size() == v.size());
+  assert(p.units().size() == 6);
+
+  for (std::size_t k = 0; k < v.size(); ++k)
+    {
+      std::ostringstream a, b;
+      a << p[k];
+      b << v[k];
+      assert(a.str() == b.str());
+      assert(p[k].size() == v[k].size());
+    }
+
+  // The queries.
+  assert(includes(p[0], CU(5, 7)));
+  assert(!includes(p[0], CU(3, 5)));
+  assert(includes(p[0], p[2]));
+  assert(includes(p[4], SU{{5, 8}}));
+  assert(includes(SU{{0, 10}}, p[0]));
+
+  // The results of the operations own their intervals.
+  auto i = intersection(p[0], p[4]);
+  static_assert(std::is_same_v<decltype(i), SU>);
+  assert(i == SU({{2, 3}, {5, 8}}));
+  assert(intersection(SU{{1, 6}}, p[0]) == SU({{1, 3}, {5, 6}}));
+  assert(intersection(CU(1, 6), p[0]) == SU({{1, 3}, {5, 6}}));
+
+  // The comparisons.
+  assert(p[0] == p[3]);
+  assert((p[0] <=> p[3]) == 0);
+  assert(p[0] > p[1] && p[0] > p[2] && p[0] > p[4]);
+  assert((p[2] <=> v[2]) == 0);
+  assert(p[4] < SU({{2, 11}}));
+}
+
+void
+test_erase_if()
+{
+  POOL p;
+  for (unsigned k = 0; k < 10; ++k)
+    {
+      SU su;
+      for (unsigned i = 0; i < k; ++i)
+        su.insert({10 * i, 10 * i + k});
+      p.append(su);
+    }
+
+  // Remove the sunits with an odd number of intervals.
+  assert(p.erase_if([](const auto &su)
+                    {return std::distance(su.begin(), su.end()) % 2;})
+         == 5);
+  assert(p.size() == 5);
+  assert(p.units().size() == 0 + 2 + 4 + 6 + 8);
+
+  p.for_each([](std::size_t k, const auto &su)
+  {
+    assert(std::size_t(std::distance(su.begin(), su.end())) == 2 * k);
+    for (const auto &cu: su)
+      assert(cu.size() == 2 * k);
+  });
+
+  p.clear();
+  assert(p.empty() && p.units().empty());
+}
+
+int
+main()
+{
+  test_views();
+  test_erase_if();
+}
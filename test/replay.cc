@@ -0,0 +1,148 @@
+// The replay of a trace of the operations on sunits (see trace.hpp),
+// to compare the performance of the stores on the same load:
+//
+// ./replay [text|binary] [vector|tree|compact|adaptive] < trace
+//
+// We read the whole trace first, and then replay the records in order
+// on the sunits with the store: we build the sunits of a checkpoint,
+// which is not timed, and time the operations on the sunits, which
+// persist from record to record.  We report the throughput, the
+// percentiles of the latency, and the checksum of the results, which
+// is the same for every store.
+
+#include "adaptive.hpp"
+#include "compact.hpp"
+#include "trace.hpp"
+#include "units.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using clk = chrono::steady_clock;
+
+template <typename C>
+void
+replay(const vector<trace_record<unsigned>> &rs)
+{
+  using S = sunits<unsigned, C>;
+
+  // The sunits by their ids.
+  vector<S> os;
+
+  vector<clk::duration> lat;
+  lat.reserve(rs.size());
+  uint64_t checksum = 0;
+
+  for (const auto &r: rs)
+    {
+      if (r.checkpoint)
+        {
+          if (r.a >= os.size())
+            os.resize(r.a + 1);
+          os[r.a] = S();
+          for (const auto &cu: r.su)
+            os[r.a].insert(cu);
+          continue;
+        }
+
+      auto &a = os.at(r.a);
+      size_t n = 0;
+
+      auto t0 = clk::now();
+      switch (r.op)
+        {
+        case units_op::insert:
+          a.insert(r.cu);
+          break;
+        case units_op::remove:
+          a.remove(r.cu);
+          break;
+        case units_op::includes:
+          checksum += includes(a, r.cu);
+          break;
+        case units_op::includes_set:
+          checksum += includes(a, os.at(r.b));
+          break;
+        case units_op::intersection:
+          n = (r.b ? intersection(a, os.at(r.b)) :
+               intersection(r.cu, a)).size();
+          break;
+        case units_op::intersect_with:
+          if (r.b)
+            a &= os.at(r.b);
+          else
+            a &= r.cu;
+          break;
+        }
+      lat.push_back(clk::now() - t0);
+
+      checksum = (checksum + n) * 31 + a.size();
+    }
+
+  auto total = clk::duration::zero();
+  for (auto d: lat)
+    total += d;
+  sort(lat.begin(), lat.end());
+
+  auto s = chrono::duration<double>(total).count();
+  cout << "operations: " << lat.size() << '\n'
+       << "checkpoints: " << rs.size() - lat.size() << '\n'
+       << "time: " << s << " s\n"
+       << "throughput: " << (s ? lat.size() / s : 0) << " ops/s\n";
+
+  // A trace of checkpoints only has no latencies.
+  if (!lat.empty())
+    for (double q: {0.5, 0.9, 0.99})
+      {
+        auto i = min<size_t>(lat.size() - 1, q * lat.size());
+        cout << "p" << int(q * 100) << ": "
+             << chrono::duration<double, nano>(lat[i]).count() << " ns\n";
+      }
+
+  cout << "checksum: " << checksum << '\n';
+}
+
+int
+main(int argc, char *argv[])
+{
+  string format = argc > 1 ? argv[1] : "text";
+  string store = argc > 2 ? argv[2] : "vector";
+
+  if (format != "text" && format != "binary")
+    {
+      cerr << "usage: " << argv[0]
+           << " [text|binary] [vector|tree|compact|adaptive] < trace\n";
+      return 1;
+    }
+
+  auto f = format == "text" ? trace_format::text : trace_format::binary;
+
+  vector<trace_record<unsigned>> rs;
+  for (trace_record<unsigned> r; read_trace_record(cin, f, r);)
+    rs.push_back(r);
+
+  if (rs.empty())
+    {
+      cerr << "no records\n";
+      return 1;
+    }
+
+  if (store == "vector")
+    replay<vector_store<unsigned>>(rs);
+  else if (store == "tree")
+    replay<tree_store<unsigned>>(rs);
+  else if (store == "compact")
+    replay<compact_store<unsigned>>(rs);
+  else if (store == "adaptive")
+    replay<adaptive_store<unsigned>>(rs);
+  else
+    {
+      cerr << "unknown store: " << store << '\n';
+      return 1;
+    }
+}
@@ -0,0 +1,110 @@
+#include "reserve.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <random>
+#include <thread>
+#include <vector>
+
+using SS = shared_sunits<unsigned>;
+using R = reservation<unsigned>;
+
+void
+test_commit()
+{
+  SS a(SU{{0, 10}}), b(SU{{0, 5}, {6, 10}});
+
+  // Not included in b, so nothing is removed.
+  assert(!R().remove(a, {4, 7}).remove(b, {4, 7}).commit());
+  assert(*a.units() == SU({{0, 10}}) && a.version() == 0);
+  assert(*b.units() == SU({{0, 5}, {6, 10}}) && b.version() == 0);
+
+  // The old snapshot stays valid.
+  auto old = a.units();
+  assert(R().remove(a, {2, 4}).remove(b, {2, 4}).commit());
+  assert(*a.units() == SU({{0, 2}, {4, 10}}) && a.version() == 2);
+  assert(*b.units() == SU({{0, 2}, {4, 5}, {6, 10}}) && b.version() == 2);
+  assert(*old == SU({{0, 10}}));
+
+  // Insert cannot overlap.
+  assert(!R().insert(a, {3, 5}).commit());
+  assert(!R().insert(a, {1, 3}).commit());
+
+  // The operations on the same sunits apply in order.
+  assert(R().insert(a, {2, 4}).remove(a, {0, 9}).insert(b, {2, 4}).commit());
+  assert(*a.units() == SU({{9, 10}}));
+  assert(*b.units() == SU({{0, 5}, {6, 10}}));
+
+  // The committed operations are not applied again, and the failed
+  // ones are kept.
+  R r;
+  assert(r.insert(a, {0, 2}).commit());
+  assert(r.commit() && a.version() == 6);
+  assert(*a.units() == SU({{0, 2}, {9, 10}}));
+  assert(!r.remove(a, {2, 3}).commit());
+  assert(!r.commit());
+}
+
+// The threads reserve the units on random paths, and then release
+// them.  A unit is reserved once at a time on a link, and in the end
+// all units are free.
+void
+test_threads()
+{
+  constexpr unsigned L = 6, U = 64;
+
+  std::vector<SS> links(L);
+  for (auto &l: links)
+    assert(R().insert(l, {0, U}).commit());
+
+  // The units reserved on the links.
+  std::vector<std::atomic<int>> reserved(L * U);
+
+  auto work = [&](unsigned seed)
+  {
+    std::mt19937 g(seed);
+
+    for (int k = 0; k < 2000; ++k)
+      {
+        unsigned f = g() % L, n = 1 + g() % (L - f);
+        unsigned a = g() % U, s = 1 + g() % 4;
+        cunits<unsigned> cu(a, std::min(a + s, U));
+
+        R r;
+        for (unsigned i = f; i < f + n; ++i)
+          r.remove(links[i], cu);
+
+        if (!r.commit())
+          continue;
+
+        for (unsigned i = f; i < f + n; ++i)
+          for (auto u = cu.min(); u < cu.max(); ++u)
+            assert(!reserved[i * U + u]++);
+
+        R q;
+        for (unsigned i = f; i < f + n; ++i)
+          {
+            for (auto u = cu.min(); u < cu.max(); ++u)
+              --reserved[i * U + u];
+            q.insert(links[i], cu);
+          }
+        assert(q.commit());
+      }
+  };
+
+  std::vector<std::thread> ts;
+  for (unsigned t = 0; t < 4; ++t)
+    ts.emplace_back(work, t);
+  for (auto &t: ts)
+    t.join();
+
+  for (auto &l: links)
+    assert(*l.units() == SU({{0, U}}) && l.version() % 2 == 0);
+}
+
+int
+main()
+{
+  test_commit();
+  test_threads();
+}
@@ -0,0 +1,69 @@
+#include "sort.hpp"
+#include "units.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+// Random sunits with a few intervals of a few units, so that many
+// have the same first intervals.
+SU
+random_su()
+{
+  SU su;
+  for (unsigned u = std::rand() % 3; u < 12; u += 1 + std::rand() % 4)
+    if (std::rand() % 2)
+      {
+        su.insert({u, u + 1});
+        ++u;
+      }
+  return su;
+}
+
+void
+test_sort(unsigned n, unsigned threads)
+{
+  std::vector<SU> v;
+  for (unsigned i = 0; i < n; ++i)
+    v.push_back(random_su());
+
+  auto s = v;
+  std::stable_sort(s.begin(), s.end());
+  auto u = s;
+  u.erase(std::unique(u.begin(), u.end()), u.end());
+
+  auto w = v;
+  sort_sunits(w.begin(), w.end(), threads);
+  assert(w == s);
+
+  w = v;
+  w.erase(sort_unique_sunits(w.begin(), w.end(), threads), w.end());
+  assert(w == u);
+}
+
+void
+test_signed()
+{
+  using S = sunits<int>;
+  std::vector<S> v = {{{-5, -3}}, {}, {{-5, -4}}, {{-5, -3}, {0, 1}},
+                      {{-6, 2}}, {{-5, -3}}};
+  sort_unique_sunits(v.begin(), v.end());
+  v.resize(5);
+  assert(std::is_sorted(v.begin(), v.end()));
+  assert(v.front().empty() && v[3] == S({{-5, -3}, {0, 1}}));
+  assert(v.back() == S({{-6, 2}}));
+}
+
+int
+main()
+{
+  std::srand(1);
+  test_sort(0, 1);
+  test_sort(1, 1);
+  test_sort(1000, 1);
+  test_sort(20000, 1);
+  test_sort(20000, 3);
+  test_sort(20000, 8);
+  test_signed();
+}
@@ -0,0 +1,61 @@
+// Enable the instrumentation.
+#define UNITS_STATS
+
+#include "units.hpp"
+
+#include <cassert>
+
+void
+test_counts()
+{
+  // The operands are built before the counting starts, because
+  // building them counts as well.
+  SU a{{25, 40}}, b{{0, 12}};
+
+  units_stats_reset();
+
+  SU s;
+  s.insert({10, 20});
+  s.insert({30, 40});
+  // Merges the three intervals into one.
+  s.insert({20, 30});
+  s.remove({15, 25});
+  assert(includes(s, CU(10, 15)));
+  assert(includes(s, a));
+  SU t = intersection(s, b);
+
+  auto st = units_stats_snapshot();
+  // Three by s, and one by intersection.
+  assert(st.insert == 4);
+  assert(st.remove == 1);
+  assert(st.includes == 2);
+  assert(st.intersection == 1);
+  assert(st.allocations > 0);
+  assert(st.bytes >= st.allocations * sizeof(CU));
+
+  // Only one interval gets shifted: remove inserts the right leftover
+  // {25, 40} first, and then shifts it to insert {10, 15} before it.
+  // The other operations happen at the end.
+  assert(st.moved == 1);
+
+  // Sets sampled after insert and remove: 1, 2, 1, 2 intervals by s,
+  // and 1 interval by t.
+  assert(st.intervals[1] == 3);
+  assert(st.intervals[2] == 2);
+}
+
+void
+test_reset()
+{
+  SU s{{0, 1}};
+  units_stats_reset();
+  auto st = units_stats_snapshot();
+  assert(!st.insert && !st.allocations && !st.intervals[1]);
+}
+
+int
+main()
+{
+  test_counts();
+  test_reset();
+}
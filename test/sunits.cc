@@ -166,6 +166,115 @@ test_size()
   assert(s.size() == 6);
 }
 
+void
+test_verify()
+{
+  SU s;
+  assert(s.verify());
+
+  for (unsigned i = 0; i < 100; i += 2)
+    {
+      s.insert({i, i + 1});
+      assert(s.verify());
+    }
+
+  // Fill the gaps to merge the intervals.
+  for (unsigned i = 1; i < 99; i += 2)
+    s.insert({i, i + 1});
+
+  assert(s.verify());
+  assert(includes(s, {0, 99}));
+}
+
+void
+test_intersection()
+{
+  SU a{{0, 10}, {20, 30}, {40, 50}};
+  SU b{{5, 25}, {45, 60}};
+  SU r{{5, 10}, {20, 25}, {45, 50}};
+
+  assert(intersection(a, b) == r);
+  assert(intersection(b, a) == r);
+  assert(intersection(SU(a), b) == r);
+  assert(intersection(a, SU(b)) == r);
+  assert(intersection(SU(a), SU(b)) == r);
+  assert(intersection(a, SU{}).empty());
+  assert(intersection(SU{}, a).empty());
+
+  assert(intersection(CU(5, 45), a) == SU({{5, 10}, {20, 30}, {40, 45}}));
+  assert(intersection(CU(10, 20), a).empty());
+  assert(intersection(CU(0, 100), SU(a)) == a);
+}
+
+void
+test_intersect_with()
+{
+  // An interval of a overlaps with many intervals of b, so the
+  // intersected intervals overtake the intervals of a.
+  SU a{{0, 100}, {200, 300}};
+  SU b{{10, 20}, {30, 40}, {50, 60}, {250, 260}, {270, 280}};
+  SU r = intersection(a, b);
+  assert(r == b);
+
+  SU c = a;
+  c.intersect_with(b);
+  assert(c == r);
+  assert(c.verify());
+
+  // Reuse the buffer of a temporary.
+  c = a;
+  c &= SU(b);
+  assert(c == r);
+
+  // And the other way round.
+  c = b;
+  c &= a;
+  assert(c == r);
+
+  // No shift needed, and so no allocation.
+  c = SU{{0, 10}, {20, 30}, {40, 50}};
+  auto p = &*c.begin();
+  c &= SU{{5, 45}};
+  assert(c == SU({{5, 10}, {20, 30}, {40, 45}}));
+  assert(&*c.begin() == p);
+
+  c &= CU(8, 25);
+  assert(c == SU({{8, 10}, {20, 25}}));
+  c &= CU(10, 20);
+  assert(c.empty());
+}
+
+// The same operations with the tree store.
+void
+test_tree_store()
+{
+  using TSU = sunits<unsigned, tree_store<unsigned>>;
+
+  TSU s;
+  for (unsigned i = 0; i < 100; i += 2)
+    s.insert({i, i + 1});
+  for (unsigned i = 1; i < 99; i += 2)
+    s.insert({i, i + 1});
+  assert(s.verify());
+  assert(includes(s, {0, 99}));
+  assert(s.size() == 99);
+
+  s.remove({10, 20});
+  s.remove({30, 40});
+  assert(s == TSU({{0, 10}, {20, 30}, {40, 99}}));
+  assert(!includes(s, {5, 25}));
+  assert(includes(s, TSU{{20, 30}, {50, 60}}));
+
+  assert(intersection(s, TSU{{5, 45}})
+         == TSU({{5, 10}, {20, 30}, {40, 45}}));
+  s &= CU(8, 25);
+  assert(s == TSU({{8, 10}, {20, 25}}));
+
+  // The same order as with the vector store.
+  assert(is_greater(TSU{{0, 3}, {5, 6}}, TSU{{0, 3}}));
+  assert(is_greater(TSU{{0, 2}}, TSU{{1, 3}}));
+}
+
 // Test <.
 void
 test_less()
@@ -184,6 +293,41 @@ test_less()
   assert(is_greater(SU{{0, 2}}, SU{{1, 3}}));
 }
 
+// Test <=> of long sunits, which compares blocks of intervals.
+void
+test_compare_long()
+{
+  using TSU = sunits<unsigned, tree_store<unsigned>>;
+
+  SU a;
+  for (unsigned i = 0; i < 40; ++i)
+    a.insert({3 * i, 3 * i + 2});
+
+  for (unsigned k = 0; k < 40; ++k)
+    for (const CU &cu: {CU(3 * k, 3 * k + 1), CU(3 * k + 1, 3 * k + 2)})
+      {
+        SU b = a;
+        b.remove({3 * k, 3 * k + 2});
+        b.insert(cu);
+
+        // The same as the element-wise comparison of the tree store.
+        TSU ta, tb;
+        for (const auto &cu: a)
+          ta.insert(cu);
+        for (const auto &cu: b)
+          tb.insert(cu);
+        assert((a <=> b) == (ta <=> tb));
+        assert((b <=> a) == (tb <=> ta));
+        assert(a > b);
+      }
+
+  // A prefix is less.
+  SU b = a;
+  b.remove({117, 119});
+  assert(is_less(b, a));
+  assert(is_equal(a, SU(a)));
+}
+
 int
 main()
 {
@@ -192,5 +336,10 @@ main()
   test_insert();
   test_remove();
   test_size();
+  test_verify();
+  test_intersection();
+  test_intersect_with();
+  test_tree_store();
   test_less();
+  test_compare_long();
 }
@@ -0,0 +1,246 @@
+// Enable the tracing.
+#define UNITS_TRACE
+
+#include "trace.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <map>
+#include <sstream>
+#include <vector>
+
+// Run the operations, and return their trace.  Set the final s.
+std::string
+run(trace_format format, SU &s)
+{
+  SU a{{0, 10}}, b{{5, 20}};
+
+  std::ostringstream out;
+  trace_start(out, format);
+
+  s = SU();
+  s.insert({10, 20});
+  s.remove({12, 14});
+  assert(includes(s, CU(15, 20)));
+  assert(!includes(s, a));
+  // The inserts of intersection are not recorded.
+  SU t = intersection(s, b);
+  t = intersection(CU(0, 18), std::move(t));
+  // The assignment isn't recorded, and so s gets a new checkpoint.
+  s = a;
+  s.insert({20, 30});
+
+  trace_stop();
+
+  // Not recorded anymore.
+  s.insert({40, 41});
+
+  return out.str();
+}
+
+std::string
+run(trace_format format)
+{
+  SU s;
+  return run(format, s);
+}
+
+std::vector<trace_record<unsigned>>
+read(const std::string &trace, trace_format format)
+{
+  std::istringstream in(trace);
+  std::vector<trace_record<unsigned>> rs;
+  for (trace_record<unsigned> r; read_trace_record(in, format, r);)
+    rs.push_back(r);
+  assert(in.eof());
+  return rs;
+}
+
+// Replay the records on the sunits of the checkpoints.
+std::map<std::uint64_t, SU>
+replay(const std::vector<trace_record<unsigned>> &rs)
+{
+  std::map<std::uint64_t, SU> os;
+
+  for (const auto &r: rs)
+    if (r.checkpoint)
+      os[r.a] = r.su;
+    else if (r.op == units_op::insert)
+      os.at(r.a).insert(r.cu);
+    else if (r.op == units_op::remove)
+      os.at(r.a).remove(r.cu);
+    else if (r.op == units_op::intersect_with)
+      {
+        if (r.b)
+          os.at(r.a) &= os.at(r.b);
+        else
+          os.at(r.a) &= r.cu;
+      }
+
+  return os;
+}
+
+void
+test_text()
+{
+  SU s;
+  auto t = run(trace_format::text, s);
+  assert(t == "C 1 {}\n"
+         "i 1 {10, 20}\n"
+         "r 1 {12, 14}\n"
+         "c 1 {15, 20}\n"
+         "C 2 {{0, 10}}\n"
+         "s 1 2\n"
+         "C 3 {{5, 20}}\n"
+         "x 1 3\n"
+         "C 4 {{10, 12}, {14, 20}}\n"
+         "x 4 {0, 18}\n"
+         "C 1 {{0, 10}}\n"
+         "i 1 {20, 30}\n");
+
+  auto rs = read(t, trace_format::text);
+  assert(rs.size() == 12);
+  assert(rs[0].checkpoint && rs[0].a == 1 && rs[0].su.empty());
+  assert(rs[1].op == units_op::insert && rs[1].a == 1 &&
+         rs[1].cu == CU(10, 20));
+  assert(rs[5].op == units_op::includes_set && rs[5].a == 1 &&
+         rs[5].b == 2);
+  assert(rs[9].op == units_op::intersection && rs[9].a == 4 &&
+         !rs[9].b && rs[9].cu == CU(0, 18));
+
+  // The replay ends with s without the last insert.
+  s.remove({40, 41});
+  assert(replay(rs).at(1) == s);
+}
+
+void
+test_binary()
+{
+  auto t = run(trace_format::binary);
+  auto rs = read(t, trace_format::binary);
+  auto ts = read(run(trace_format::text), trace_format::text);
+
+  assert(rs.size() == ts.size());
+  for (std::size_t i = 0; i < rs.size(); ++i)
+    assert(rs[i].checkpoint == ts[i].checkpoint && rs[i].op == ts[i].op &&
+           rs[i].a == ts[i].a && rs[i].b == ts[i].b &&
+           rs[i].cu == ts[i].cu && rs[i].su == ts[i].su);
+}
+
+// The trace of the intersection in place, which is the same for the
+// stores that intersect in place, and those that assign.
+template <typename S>
+std::string
+run_with(trace_format format, S &s)
+{
+  S a{{0, 10}, {12, 30}};
+
+  std::ostringstream out;
+  trace_start(out, format);
+
+  s = S{{5, 25}};
+  s &= a;
+  s &= CU(6, 20);
+  s.insert({0, 2});
+  s &= S{{1, 8}, {14, 15}};
+  s.remove({14, 15});
+
+  trace_stop();
+
+  return out.str();
+}
+
+void
+test_with()
+{
+  SU s;
+  sunits<unsigned, tree_store<unsigned>> ts;
+  auto t = run_with(trace_format::text, s);
+
+  // The temporaries are recorded as they are built.
+  assert(t == "C 1 {}\n"
+         "i 1 {5, 25}\n"
+         "C 2 {{5, 25}}\n"
+         "C 3 {{0, 10}, {12, 30}}\n"
+         "w 2 3\n"
+         "w 2 {6, 20}\n"
+         "i 2 {0, 2}\n"
+         "C 4 {}\n"
+         "i 4 {1, 8}\n"
+         "i 4 {14, 15}\n"
+         "w 2 4\n"
+         "r 2 {14, 15}\n");
+  assert(run_with(trace_format::text, ts) == t);
+  assert(run_with(trace_format::binary, s) ==
+         run_with(trace_format::binary, ts));
+
+  auto rs = read(t, trace_format::text);
+  assert(rs[5].op == units_op::intersect_with && rs[5].a == 2 &&
+         !rs[5].b && rs[5].cu == CU(6, 20));
+  assert(replay(rs).at(2) == s);
+  assert(replay(read(run_with(trace_format::binary, s),
+                     trace_format::binary)).at(2) == s);
+}
+
+// A copy is new to the recording, and a session starts the ids anew.
+void
+test_generation()
+{
+  SU s{{0, 2}};
+
+  std::ostringstream out;
+  trace_start(out);
+  s.insert({4, 5});
+  SU c = s;
+  c.insert({6, 7});
+  s.insert({8, 9});
+  trace_stop();
+
+  assert(out.str() == "C 1 {{0, 2}}\n"
+         "i 1 {4, 5}\n"
+         "C 2 {{0, 2}, {4, 5}}\n"
+         "i 2 {6, 7}\n"
+         "i 1 {8, 9}\n");
+
+  out.str("");
+  trace_start(out);
+  c.insert({10, 11});
+  trace_stop();
+
+  assert(out.str() == "C 1 {{0, 2}, {4, 5}, {6, 7}}\n"
+         "i 1 {10, 11}\n");
+}
+
+// The records don't grow with the sunits.
+void
+test_size()
+{
+  SU s;
+  for (unsigned i = 0; i < 10000; i += 2)
+    s.insert({i, i + 1});
+
+  std::ostringstream out;
+  trace_start(out, trace_format::binary);
+  s.remove({0, 1});
+  auto n = out.str().size();
+  for (unsigned i = 1; i < 100; ++i)
+    {
+      s.remove({i * 2, i * 2 + 1});
+      s.insert({i * 2, i * 2 + 1});
+    }
+  trace_stop();
+
+  // A record takes 5 bytes at most: the type, the id, the min and the
+  // size.
+  assert(out.str().size() - n <= 2 * 99 * 5);
+}
+
+int
+main()
+{
+  test_text();
+  test_binary();
+  test_with();
+  test_generation();
+  test_size();
+}
@@ -0,0 +1,96 @@
+#include "views.hpp"
+#include "units.hpp"
+
+#include <cassert>
+#include <random>
+
+// The views must not clash with std::views.
+using namespace std;
+
+// Are the intervals of range r those of su?
+template <typename R>
+bool
+same(R &&r, const SU &su)
+{
+  return units_views::to<SU>(r) == su;
+}
+
+void
+test_views()
+{
+  SU a{{0, 10}, {20, 30}, {40, 50}};
+  SU b{{5, 25}, {45, 60}};
+  SU c{{8, 42}};
+
+  assert(same(units_views::intersect(a, b), {{5, 10}, {20, 25}, {45, 50}}));
+  assert(same(units_views::unite(a, b), {{0, 30}, {40, 60}}));
+  assert(same(units_views::subtract(a, b), {{0, 5}, {25, 30}, {40, 45}}));
+  assert(same(units_views::subtract(b, a), {{10, 20}, {50, 60}}));
+
+  // Nested, with an rvalue operand.
+  auto v = units_views::intersect(a, units_views::unite(b, SU{{8, 42}}));
+  assert(same(v, {{5, 10}, {20, 30}, {40, 42}, {45, 50}}));
+  assert(same(v, intersection(a, SU{{5, 42}, {45, 60}})));
+  assert(units_views::size(v) == 22);
+  assert(units_views::includes(v, CU(20, 30)));
+  assert(!units_views::includes(v, CU(20, 31)));
+  assert(!units_views::includes(v, CU(42, 45)));
+  assert(units_views::first_fit(v, 10) == CU(20, 30));
+  assert(units_views::first_fit(v, 3) == CU(5, 8));
+  assert(!units_views::first_fit(v, 11));
+
+  // The terminal operations work with sunits too.
+  assert(units_views::size(a) == 30);
+
+  // Touching intervals get merged.
+  assert(same(units_views::unite(SU{{0, 5}}, SU{{5, 10}}), {{0, 10}}));
+  assert(same(units_views::subtract(c, c), {}));
+  assert(same(units_views::intersect(a, SU{}), {}));
+}
+
+// Compare with the units one by one.
+void
+test_random()
+{
+  std::mt19937 g(1);
+
+  auto random = [&](unsigned u)
+  {
+    SU s;
+    for (unsigned i = 0; i < u; ++i)
+      if (g() % 2)
+        s.insert({i, i + 1});
+    return s;
+  };
+
+  for (int n = 0; n < 1000; ++n)
+    {
+      unsigned u = 1 + g() % 50;
+      SU a = random(u), b = random(u), c = random(u);
+      SU i, un, s;
+
+      for (unsigned k = 0; k < u; ++k)
+        {
+          CU cu(k, k + 1);
+          bool ia = includes(a, cu), ib = includes(b, cu);
+          bool ic = includes(c, cu);
+          if (ia && (ib || ic))
+            i.insert(cu);
+          if (ia || ib)
+            un.insert(cu);
+          if (ia && !ib)
+            s.insert(cu);
+        }
+
+      assert(same(units_views::intersect(a, units_views::unite(b, c)), i));
+      assert(same(units_views::unite(a, b), un));
+      assert(same(units_views::subtract(a, b), s));
+    }
+}
+
+int
+main()
+{
+  test_views();
+  test_random();
+}
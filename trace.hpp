@@ -0,0 +1,352 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "cunits.hpp"
+#include "delta.hpp"
+#include "sunits.hpp"
+
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+
+// The recording of the operations on sunits for the replay, e.g.,
+// with test/replay.cc.  Define UNITS_TRACE to have sunits call the
+// recording (see sunits.hpp), and then start the recording:
+//
+// std::ofstream out("trace.bin", std::ios::binary);
+// trace_start(out, trace_format::binary);
+//
+// Every sunits the operations are called on gets an id, starting with
+// 1, which sunits keeps with its generation (see sunits.hpp).  The
+// first time we see sunits, or when it has changed since its last
+// record (e.g., it was assigned to), we write its checkpoint: the id
+// and the intervals.  The records of the operations have the ids of
+// their sunits operands, so a record is small regardless of the size
+// of the sunits, and the replay applies the operations in order to
+// the sunits of the checkpoints.  We find the changes by the
+// generation, which takes O(1) time, and we keep nothing of the
+// sunits.  The records are:
+//
+// * 'C' - checkpoint: the id and the sunits,
+//
+// * 'i' - insert: the id and the cunits,
+//
+// * 'r' - remove: the id and the cunits,
+//
+// * 'c' - includes: the id and the cunits,
+//
+// * 's' - includes: the ids,
+//
+// * 'x' - intersection: the ids, or the id and the cunits (then the
+//   sunits operand goes first),
+//
+// * 'w' - intersect_with: the ids, or the id and the cunits.
+//
+// In the text format, a record is a line with the record type, the
+// ids, and the sunits or the cunits written with the stream
+// operators, e.g.:
+//
+// C 1 {{0, 2}, {5, 8}}
+// i 1 {3, 4}
+// x 1 2
+//
+// In the binary format, the checkpoint is the checkpoint of delta.hpp
+// with the id for the sequence number.  The other records are the
+// record type, and the ids and the cunits as varints: the cunits as
+// the min and the size, as in the delta of delta.hpp.  The second
+// operand of 'x' and 'w' is the id, or 0 followed by the cunits.  We
+// record the sunits of integral endpoints only.
+
+enum class trace_format {text, binary};
+
+struct units_tracer
+{
+  std::ostream *m_out = nullptr;
+  trace_format m_format = trace_format::text;
+  std::mutex m_mutex;
+
+  // The recording session, and the last id given in it.
+  std::uint64_t m_session = 0;
+  std::uint64_t m_id = 0;
+};
+
+inline units_tracer units_trace;
+
+// Start recording to out in the format.
+inline void
+trace_start(std::ostream &out, trace_format format = trace_format::text)
+{
+  std::lock_guard lock(units_trace.m_mutex);
+  units_trace.m_out = &out;
+  units_trace.m_format = format;
+  ++units_trace.m_session;
+  units_trace.m_id = 0;
+}
+
+inline void
+trace_stop()
+{
+  std::lock_guard lock(units_trace.m_mutex);
+  units_trace.m_out = nullptr;
+}
+
+template <std::integral T>
+std::ostream &
+write_trace_operand(std::ostream &out, const cunits<T> &cu)
+{
+  using U = std::make_unsigned_t<T>;
+
+  write_varint(out, zigzag(cu.min()));
+  return write_varint(out, U(U(cu.max()) - U(cu.min())));
+}
+
+inline std::ostream &
+write_trace_operand(std::ostream &out, std::uint64_t id)
+{
+  return write_varint(out, id);
+}
+
+// Write the checkpoint of sunits su with the id.
+template <std::integral T, typename C>
+std::ostream &
+write_trace_checkpoint(std::ostream &out, trace_format format,
+                       std::uint64_t id, const sunits<T, C> &su)
+{
+  if (format == trace_format::text)
+    return out << "C " << id << ' ' << su << '\n';
+
+  return write_checkpoint(out, su, id);
+}
+
+// Write the record of the operation on the sunits with id a, and
+// operand b: the id or the cunits.
+template <typename B>
+std::ostream &
+write_trace_record(std::ostream &out, trace_format format, units_op op,
+                   std::uint64_t a, const B &b)
+{
+  if (format == trace_format::text)
+    return out << char(op) << ' ' << a << ' ' << b << '\n';
+
+  out.put(char(op));
+  write_varint(out, a);
+  if constexpr (!std::same_as<B, std::uint64_t>)
+    if (op == units_op::intersection || op == units_op::intersect_with)
+      write_varint(out, 0);
+  return write_trace_operand(out, b);
+}
+
+// The id of sunits su.  We write its checkpoint if we haven't seen it
+// yet, or if it has changed since its last record.
+template <std::integral T, typename C>
+std::uint64_t
+trace_object(const sunits<T, C> &su)
+{
+  auto &g = su.generation();
+
+  if (g.m_session != units_trace.m_session)
+    {
+      g.m_session = units_trace.m_session;
+      g.m_id = ++units_trace.m_id;
+    }
+  else if (g.m_gen == g.m_recorded)
+    return g.m_id;
+
+  write_trace_checkpoint(*units_trace.m_out, units_trace.m_format, g.m_id,
+                         su);
+  g.m_recorded = g.m_gen;
+  return g.m_id;
+}
+
+// The operation that is yet to be done changes sunits su, and that's
+// a single change (see trace_change), which the replay does too.
+template <std::integral T, typename C>
+void
+trace_changed(units_op op, const sunits<T, C> &su)
+{
+  if (op == units_op::insert || op == units_op::remove ||
+      op == units_op::intersect_with)
+    su.generation().m_recorded = su.generation().m_gen + 1;
+}
+
+template <std::integral T, typename C>
+void
+units_trace_record(units_op op, const sunits<T, C> &a, const cunits<T> &b)
+{
+  std::lock_guard lock(units_trace.m_mutex);
+  if (!units_trace.m_out)
+    return;
+
+  auto id = trace_object(a);
+  write_trace_record(*units_trace.m_out, units_trace.m_format, op, id, b);
+  trace_changed(op, a);
+}
+
+template <std::integral T, typename C1, typename C2>
+void
+units_trace_record(units_op op, const sunits<T, C1> &a,
+                   const sunits<T, C2> &b)
+{
+  std::lock_guard lock(units_trace.m_mutex);
+  if (!units_trace.m_out)
+    return;
+
+  auto ida = trace_object(a);
+  auto idb = trace_object(b);
+  write_trace_record(*units_trace.m_out, units_trace.m_format, op, ida,
+                     idb);
+  trace_changed(op, a);
+}
+
+template <std::integral T, typename C>
+void
+units_trace_record(units_op op, const cunits<T> &a, const sunits<T, C> &b)
+{
+  units_trace_record(op, b, a);
+}
+
+// We don't record the other sunits.
+template <typename... A>
+void
+units_trace_record(units_op, const A &...)
+{
+}
+
+// The record read back: the checkpoint of the sunits with id a, or
+// the operation on the sunits with id a, and the sunits with id b, or
+// cunits cu if b is 0.
+template <typename T>
+struct trace_record
+{
+  bool checkpoint = false;
+  units_op op = units_op::insert;
+  std::uint64_t a = 0, b = 0;
+  cunits<T> cu = cunits<T>(0, 1);
+  sunits<T> su;
+};
+
+// Read sunits in the text format, which can be empty.
+template <std::integral T>
+std::istream &
+read_trace_operand(std::istream &in, sunits<T> &su)
+{
+  char c;
+
+  if (!(in >> c) || c != '{')
+    {
+      in.setstate(std::ios::failbit);
+      return in;
+    }
+
+  if (in >> std::ws; in.peek() == '}')
+    {
+      in.get();
+      return in;
+    }
+
+  for (cunits<T> cu(0, 1); in >> cu;)
+    {
+      su.insert(cu);
+
+      if (!(in >> c) || c == '}')
+        break;
+    }
+
+  return in;
+}
+
+// Read cunits in the binary format.
+template <std::integral T>
+std::istream &
+read_trace_operand(std::istream &in, cunits<T> &cu)
+{
+  std::uint64_t min, s;
+  T m, x;
+
+  if (read_varint(in, min) && read_varint(in, s) &&
+      decode_endpoint(min, m) && advance_endpoint(m, s, x))
+    cu = cunits<T>(m, x);
+  else
+    in.setstate(std::ios::failbit);
+
+  return in;
+}
+
+// Read a record in the format.
+template <std::integral T>
+std::istream &
+read_trace_record(std::istream &in, trace_format format,
+                  trace_record<T> &r)
+{
+  r = trace_record<T>();
+
+  if (format == trace_format::text)
+    in >> std::ws;
+
+  int op = in.peek();
+
+  if (op == 'C')
+    {
+      r.checkpoint = true;
+
+      if (format == trace_format::binary)
+        read_checkpoint(in, r.su, r.a);
+      else
+        {
+          in.get();
+          in >> r.a;
+          read_trace_operand(in, r.su);
+        }
+
+      // The ids start with 1.
+      if (!r.a)
+        in.setstate(std::ios::failbit);
+
+      return in;
+    }
+
+  if (op != 'i' && op != 'r' && op != 'c' && op != 's' && op != 'x' &&
+      op != 'w')
+    {
+      in.setstate(std::ios::failbit);
+      return in;
+    }
+
+  in.get();
+  r.op = units_op(op);
+
+  // Does the operation have a cunits operand?
+  bool cu = op == 'i' || op == 'r' || op == 'c';
+
+  if (format == trace_format::text)
+    {
+      in >> r.a >> std::ws;
+
+      if ((op == 'x' || op == 'w') && in.peek() == '{')
+        cu = true;
+
+      if (cu)
+        in >> r.cu;
+      else
+        in >> r.b;
+    }
+  else
+    {
+      read_varint(in, r.a);
+
+      if (!cu)
+        if (read_varint(in, r.b); (op == 'x' || op == 'w') && !r.b)
+          cu = true;
+
+      if (cu)
+        read_trace_operand(in, r.cu);
+    }
+
+  if (!r.a || (!cu && !r.b))
+    in.setstate(std::ios::failbit);
+
+  return in;
+}
+
+#endif // TRACE_HPP
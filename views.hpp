@@ -0,0 +1,468 @@
+#ifndef VIEWS_HPP
+#define VIEWS_HPP
+
+#include "cunits.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+// Lazy set expressions over sunits.  The views yield the intervals of
+// the intersection, the union or the difference of their operands on
+// demand, without building the intermediate sunits, e.g.:
+//
+// auto v = units_views::intersect(a, units_views::unite(b, c));
+// if (auto cu = units_views::first_fit(v, 10)) ...
+//
+// The operands are sunits or other views: ranges of non-overlapping
+// and non-adjacent intervals sorted from left to right, as sunits
+// keeps them.  The views yield such intervals too.  Lvalue operands
+// are referenced, so they must outlive the view, and rvalue operands
+// are moved into the view.
+//
+// The views are input ranges: the iterators yield cunits by value,
+// and every iterator computes the expression anew.
+
+namespace units_views {
+
+// The type of the intervals of range R.
+template <typename R>
+using data_type = std::ranges::range_value_t<R>;
+
+// The base of the iterators of the views: keeps the current interval,
+// which is empty at the end.
+template <typename V>
+class iterator_base
+{
+protected:
+  std::optional<V> m_cu;
+
+public:
+  using value_type = V;
+  using difference_type = std::ptrdiff_t;
+
+  const V &
+  operator * () const
+  {
+    return *m_cu;
+  }
+
+  const V *
+  operator -> () const
+  {
+    return &*m_cu;
+  }
+
+  bool
+  operator == (std::default_sentinel_t) const
+  {
+    return !m_cu;
+  }
+};
+
+// The position in operand R: the current and the end iterators.
+template <typename R>
+struct cursor
+{
+  std::ranges::iterator_t<const R> i;
+  std::ranges::sentinel_t<const R> e;
+
+  cursor() = default;
+
+  cursor(const R &r): i(std::ranges::begin(r)), e(std::ranges::end(r))
+  {
+  }
+
+  bool
+  done() const
+  {
+    return i == e;
+  }
+};
+
+// The intersection of operands A and B.
+template <std::ranges::view A, std::ranges::view B>
+class intersect_view:
+  public std::ranges::view_interface<intersect_view<A, B>>
+{
+  A m_a;
+  B m_b;
+
+public:
+  intersect_view(A a, B b): m_a(std::move(a)), m_b(std::move(b))
+  {
+  }
+
+  class iterator: public iterator_base<data_type<A>>
+  {
+    cursor<A> m_i;
+    cursor<B> m_j;
+
+  public:
+    iterator() = default;
+
+    iterator(const A &a, const B &b): m_i(a), m_j(b)
+    {
+      next();
+    }
+
+    iterator &
+    operator ++ ()
+    {
+      next();
+      return *this;
+    }
+
+    void
+    operator ++ (int)
+    {
+      next();
+    }
+
+  private:
+    // Find the next overlap of the intervals of the operands.  The
+    // same as in function intersection of sunits.
+    void
+    next()
+    {
+      while(!m_i.done() && !m_j.done())
+        {
+          auto i = *m_i.i;
+          auto j = *m_j.i;
+
+          if (i.max() <= j.min())
+            {
+              ++m_i.i;
+              continue;
+            }
+
+          if (j.max() <= i.min())
+            {
+              ++m_j.i;
+              continue;
+            }
+
+          this->m_cu.emplace(std::max(i.min(), j.min()),
+                             std::min(i.max(), j.max()));
+          if (i.max() < j.max())
+            ++m_i.i;
+          else
+            ++m_j.i;
+          return;
+        }
+
+      this->m_cu.reset();
+    }
+  };
+
+  iterator
+  begin() const
+  {
+    return iterator(m_a, m_b);
+  }
+
+  std::default_sentinel_t
+  end() const
+  {
+    return {};
+  }
+};
+
+// The union of operands A and B.
+template <std::ranges::view A, std::ranges::view B>
+class unite_view: public std::ranges::view_interface<unite_view<A, B>>
+{
+  A m_a;
+  B m_b;
+
+public:
+  unite_view(A a, B b): m_a(std::move(a)), m_b(std::move(b))
+  {
+  }
+
+  class iterator: public iterator_base<data_type<A>>
+  {
+    cursor<A> m_i;
+    cursor<B> m_j;
+
+  public:
+    iterator() = default;
+
+    iterator(const A &a, const B &b): m_i(a), m_j(b)
+    {
+      next();
+    }
+
+    iterator &
+    operator ++ ()
+    {
+      next();
+      return *this;
+    }
+
+    void
+    operator ++ (int)
+    {
+      next();
+    }
+
+  private:
+    // Take the interval with the lower min, and merge into it the
+    // intervals of both operands that overlap or touch it.
+    void
+    next()
+    {
+      if (m_i.done() && m_j.done())
+        {
+          this->m_cu.reset();
+          return;
+        }
+
+      bool left = !m_i.done() &&
+        (m_j.done() || (*m_i.i).min() < (*m_j.i).min());
+      auto [min, max] = left ? take(m_i) : take(m_j);
+
+      for (bool more = true; more;)
+        {
+          more = false;
+          more |= merge(m_i, max);
+          more |= merge(m_j, max);
+        }
+
+      this->m_cu.emplace(min, max);
+    }
+
+    // Take the endpoints of the current interval of c.
+    template <typename C>
+    static auto
+    take(C &c)
+    {
+      auto cu = *c.i;
+      ++c.i;
+      return std::pair(cu.min(), cu.max());
+    }
+
+    // Merge the intervals of c that start at or before max.
+    template <typename C, typename T>
+    static bool
+    merge(C &c, T &max)
+    {
+      bool merged = false;
+
+      for (; !c.done() && (*c.i).min() <= max; ++c.i, merged = true)
+        max = std::max(max, (*c.i).max());
+
+      return merged;
+    }
+  };
+
+  iterator
+  begin() const
+  {
+    return iterator(m_a, m_b);
+  }
+
+  std::default_sentinel_t
+  end() const
+  {
+    return {};
+  }
+};
+
+// The difference of operands A and B: the units of A that are not in
+// B.
+template <std::ranges::view A, std::ranges::view B>
+class subtract_view:
+  public std::ranges::view_interface<subtract_view<A, B>>
+{
+  A m_a;
+  B m_b;
+
+public:
+  subtract_view(A a, B b): m_a(std::move(a)), m_b(std::move(b))
+  {
+  }
+
+  class iterator: public iterator_base<data_type<A>>
+  {
+    cursor<A> m_i;
+    cursor<B> m_j;
+
+    // What is left of the current interval of A.
+    std::optional<data_type<A>> m_rest;
+
+  public:
+    iterator() = default;
+
+    iterator(const A &a, const B &b): m_i(a), m_j(b)
+    {
+      next();
+    }
+
+    iterator &
+    operator ++ ()
+    {
+      next();
+      return *this;
+    }
+
+    void
+    operator ++ (int)
+    {
+      next();
+    }
+
+  private:
+    void
+    next()
+    {
+      while(true)
+        {
+          if (!m_rest)
+            {
+              if (m_i.done())
+                {
+                  this->m_cu.reset();
+                  return;
+                }
+
+              m_rest = *m_i.i;
+              ++m_i.i;
+            }
+
+          auto r = *m_rest;
+
+          // Skip the intervals of B that precede r.  We do not skip
+          // the interval of B that overlaps with r, because it can
+          // overlap with the next interval of A too.
+          while(!m_j.done() && (*m_j.i).max() <= r.min())
+            ++m_j.i;
+
+          // Nothing in B overlaps with r.
+          if (m_j.done() || r.max() <= (*m_j.i).min())
+            {
+              this->m_cu = r;
+              m_rest.reset();
+              return;
+            }
+
+          auto j = *m_j.i;
+
+          // What is left of r on the right of j.
+          if (j.max() < r.max())
+            m_rest.emplace(j.max(), r.max());
+          else
+            m_rest.reset();
+
+          // What is left of r on the left of j.
+          if (r.min() < j.min())
+            {
+              this->m_cu.emplace(r.min(), j.min());
+              return;
+            }
+        }
+    }
+  };
+
+  iterator
+  begin() const
+  {
+    return iterator(m_a, m_b);
+  }
+
+  std::default_sentinel_t
+  end() const
+  {
+    return {};
+  }
+};
+
+template <typename A, typename B>
+auto
+intersect(A &&a, B &&b)
+{
+  return intersect_view(std::views::all(std::forward<A>(a)),
+                        std::views::all(std::forward<B>(b)));
+}
+
+template <typename A, typename B>
+auto
+unite(A &&a, B &&b)
+{
+  return unite_view(std::views::all(std::forward<A>(a)),
+                    std::views::all(std::forward<B>(b)));
+}
+
+template <typename A, typename B>
+auto
+subtract(A &&a, B &&b)
+{
+  return subtract_view(std::views::all(std::forward<A>(a)),
+                       std::views::all(std::forward<B>(b)));
+}
+
+// The type of the number of units of range R.
+template <typename R>
+using units_type = decltype(std::declval<data_type<R>>().size());
+
+// The number of units.
+template <std::ranges::input_range R>
+auto
+size(R &&r)
+{
+  units_type<R> s{};
+
+  for (const auto &cu: r)
+    s += cu.size();
+
+  return s;
+}
+
+// Interval cu has to be included.
+template <std::ranges::input_range R>
+bool
+includes(R &&r, const data_type<R> &cu)
+{
+  for (const auto &i: r)
+    {
+      if (::includes(i, cu))
+        return true;
+
+      // The intervals that follow start later than cu.
+      if (cu.min() < i.max())
+        return false;
+    }
+
+  return false;
+}
+
+// The first n units of the first interval that has them.
+template <std::ranges::input_range R>
+std::optional<data_type<R>>
+first_fit(R &&r, units_type<R> n)
+{
+  for (const auto &cu: r)
+    if (n <= cu.size())
+      return data_type<R>(cu.min(), cu.min() + n);
+
+  return std::nullopt;
+}
+
+// Build set S, e.g., a sunits, of the intervals.
+template <typename S, std::ranges::input_range R>
+S
+to(R &&r)
+{
+  S ret;
+
+  for (const auto &cu: r)
+    ret.insert(cu);
+
+  return ret;
+}
+
+} // namespace units_views
+
+#endif // VIEWS_HPP